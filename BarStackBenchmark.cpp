@@ -0,0 +1,1092 @@
+// Headless benchmark of the plot_bar_stack rendering path.
+// Creates ImGui/ImPlot contexts with a dummy display size and no window or renderer backend, then drives
+// BeginPlot/plot_bar_stack/EndPlot frames over synthetic lanes and reports per frame:
+// - ns/segment: time spent in plot_bar_stack divided by the number of segments of the lane
+// - vertices emitted by plot_bar_stack, and draw commands of the whole frame
+// - heap allocations, through both ImGui's allocator hooks and every replaceable global operator new
+// It then checks that a panning view, which misses every cache, plots without heap allocations once warmed up, for
+// timelines and for raw lengths from arrays, std::vector and std::string labels,
+// that a timeline rebuilt at the address of the previous one is not replayed from the caches, that enum states get one
+// color each, that signed integers of every width get the sign colors of int, that strip rows are rasterised pixel
+// exact, that push_transition() after append() leaves no gap, that a pyramid kept up to date while appending matches a
+// rebuilt one, that compressed timelines decode what was appended, that the ingest queue counts what it drops and keeps
+// the order of each producer, that capture files read back what was written, that BarStackFlags_Follow draws the bars
+// of the plain path after appends and refills, that a stack rendered in parallel matches the serial one down to the
+// draw commands, that runs of one color are only looked for around the visible segments of a timeline and never in a
+// view, that a panned strip moves over its texture row instead of rasterising it again, and that a plot_bar_stack call
+// made from inside another one keeps the stats of both, and exits with 1 when a check fails.
+// Build it from the same sources as ImplotTest.cpp, without the GLFW/OpenGL backends. With Dear ImGui and ImPlot checked
+// out into imgui/ next to this file, see README.md:
+//   c++ -std=c++17 -O2 -I. -Iimgui -o bar_stack_benchmark BarStackBenchmark.cpp plot_bar_stack_util.cpp bar_stack_capture.cpp bar_stack_ingest.cpp
+//       imgui/imgui.cpp imgui/imgui_draw.cpp imgui/imgui_tables.cpp imgui/imgui_widgets.cpp imgui/implot.cpp imgui/implot_items.cpp -lpthread
+
+#include "imgui/imgui.h"
+#include "imgui/implot.h"
+#include "implot_internal.h"
+#include "plot_bar_stack_util.h"
+#include "bar_stack_capture.h"
+#include "bar_stack_ingest.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Allocation counting
+//-----------------------------------------------------------------------------
+
+static std::atomic<long long> g_allocations(0);
+
+static void* counting_alloc(size_t size, void*)
+{
+    g_allocations++;
+    return malloc(size);
+}
+
+static void counting_free(void* ptr, void*)
+{
+    free(ptr);
+}
+
+// Every replaceable operator new is counted: plain, array, nothrow and over-aligned
+static void* counted_malloc(size_t size)
+{
+    g_allocations++;
+    return malloc(size ? size : 1);
+}
+
+static void* counted_aligned_malloc(size_t size, std::align_val_t alignment)
+{
+    g_allocations++;
+    const size_t align = std::max((size_t)alignment, sizeof(void*));
+#if defined(_WIN32)
+    return _aligned_malloc(size ? size : 1, align);
+#else
+    void* ptr = nullptr;
+    return posix_memalign(&ptr, align, size ? size : 1) == 0 ? ptr : nullptr;
+#endif
+}
+
+static void aligned_free(void* ptr)
+{
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+void* operator new(size_t size)
+{
+    if (void* ptr = counted_malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    if (void* ptr = counted_malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_malloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_malloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    if (void* ptr = counted_aligned_malloc(size, alignment))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    if (void* ptr = counted_aligned_malloc(size, alignment))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return counted_aligned_malloc(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return counted_aligned_malloc(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept                                               { free(ptr); }
+void operator delete[](void* ptr) noexcept                                             { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept                                       { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept                                     { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept                        { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept                      { free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept                             { aligned_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept                           { aligned_free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept                     { aligned_free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept                   { aligned_free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept      { aligned_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept    { aligned_free(ptr); }
+
+//-----------------------------------------------------------------------------
+// Benchmark
+//-----------------------------------------------------------------------------
+
+static const ImVec2 DISPLAY_SIZE(1920, 1080);
+static const int    WARMUP_FRAMES = 3;
+static const int    MEASURED_FRAMES = 10;
+static const int    STEADY_FRAMES = 60;
+
+enum BenchMode
+{
+    BenchMode_Lod,        // default level of detail aggregation
+    BenchMode_NoLod,      // every segment drawn
+    BenchMode_Compressed, // compressed timeline, only the visible blocks decoded
+    BenchMode_Pyramid,    // timeline with a multi-resolution pyramid
+    BenchMode_COUNT
+};
+
+static const char* bench_mode_name(int mode)
+{
+    switch (mode)
+    {
+    case BenchMode_Lod:        return "lod";
+    case BenchMode_NoLod:      return "nolod";
+    case BenchMode_Compressed: return "packed";
+    case BenchMode_Pyramid:    return "pyramid";
+    default:                   return "?";
+    }
+}
+
+struct FrameStats
+{
+    double    plot_ns;
+    int       vertices;
+    int       draw_cmds;
+    long long allocations;
+};
+
+// Synthetic lane: pseudo random durations of 1 to 16 time units cycling through 6 states
+static void build_lane(BarStackTimeline<ImU8>& timeline, int count)
+{
+    timeline.clear();
+    timeline.reserve(count);
+    unsigned int seed = 12345;
+    for (int i = 0; i < count; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        timeline.append(1 + (seed >> 28), (ImU8)(i % 6));
+    }
+}
+
+// Runs one frame with a plot over [x_min, x_max] in which plot() draws its items
+template <typename Plot>
+static FrameStats run_plot_frame(double x_min, double x_max, Plot plot)
+{
+    FrameStats stats = {};
+    ImGui::NewFrame();
+    ImGui::SetNextWindowPos(ImVec2(0, 0));
+    ImGui::SetNextWindowSize(DISPLAY_SIZE);
+    ImGui::Begin("Benchmark", nullptr, ImGuiWindowFlags_NoDecoration);
+    if (ImPlot::BeginPlot("##Benchmark", ImVec2(-1, -1)))
+    {
+        ImPlot::SetupAxes("Time", "Topic", 0, ImPlotAxisFlags_AutoFit);
+        ImPlot::SetupAxisLimits(ImAxis_X1, x_min, x_max, ImPlotCond_Always);
+        ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+        const int vtx_before = draw_list.VtxBuffer.Size;
+        const long long alloc_before = g_allocations;
+        const auto start = std::chrono::steady_clock::now();
+        plot();
+        const auto stop = std::chrono::steady_clock::now();
+        stats.plot_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+        stats.vertices = draw_list.VtxBuffer.Size - vtx_before;
+        stats.allocations = g_allocations - alloc_before;
+        ImPlot::EndPlot();
+    }
+    ImGui::End();
+    ImGui::Render();
+    const ImDrawData* draw_data = ImGui::GetDrawData();
+    for (int i = 0; i < draw_data->CmdListsCount; ++i)
+        stats.draw_cmds += draw_data->CmdLists[i]->CmdBuffer.Size;
+    return stats;
+}
+
+template <typename Timeline>
+static FrameStats run_frame(const Timeline& timeline, double x_min, double x_max, ImPlotBarGroupsFlags flags)
+{
+    return run_plot_frame(x_min, x_max, [&]() { plot_bar_stack("lane", timeline, 0.5, 0, flags | ImPlotBarGroupsFlags_Horizontal); });
+}
+
+// Plots a timeline rebuilt on the stack, so every frame it sits at the same address with the same number of segments,
+// and returns the color of its first vertex. The states differ with frame, a replay of the previous frame would keep the color.
+static ImU32 plot_rebuilt_timeline(int frame)
+{
+    BarStackTimeline<ImU8> local;
+    local.append(10, (ImU8)frame);
+    local.append(10, (ImU8)(frame + 1));
+    ImU32 color = 0;
+    run_plot_frame(0, 20, [&]()
+    {
+        ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+        const int vtx_before = draw_list.VtxBuffer.Size;
+        plot_bar_stack("rebuilt", local, 0.5, 0, ImPlotBarGroupsFlags_Horizontal);
+        if (draw_list.VtxBuffer.Size > vtx_before)
+            color = draw_list.VtxBuffer[vtx_before].col;
+    });
+    return color;
+}
+
+template <typename Timeline>
+static void run_case(const Timeline& timeline, int mode, double zoom)
+{
+    const double span = (double)(timeline.end() - timeline.origin);
+    const double center = timeline.origin + span * 0.5;
+    const double x_min = center - span * zoom * 0.5;
+    const double x_max = center + span * zoom * 0.5;
+    const ImPlotBarGroupsFlags flags = mode == BenchMode_NoLod ? BarStackFlags_NoLod : 0;
+    std::vector<FrameStats> frames;
+    for (int f = 0; f < WARMUP_FRAMES + MEASURED_FRAMES; ++f)
+    {
+        FrameStats stats = run_frame(timeline, x_min, x_max, flags);
+        if (f >= WARMUP_FRAMES)
+            frames.push_back(stats);
+    }
+    std::sort(frames.begin(), frames.end(), [](const FrameStats& a, const FrameStats& b) { return a.plot_ns < b.plot_ns; });
+    const FrameStats& median = frames[frames.size() / 2];
+    long long allocations = 0;
+    for (const FrameStats& stats : frames)
+        allocations += stats.allocations;
+    printf("%-8s %10d %10g %12.3f %12.1f %10d %8d %10.1f\n",
+        bench_mode_name(mode), timeline.count(), zoom, median.plot_ns / timeline.count(), median.plot_ns / 1000.0,
+        median.vertices, median.draw_cmds, (double)allocations / frames.size());
+}
+
+// Pans over 5% of a lane spanning [origin, end] in steps of a third of the view, so every frame renders different segments.
+// The pan is played once to warm up the scratch buffers and worker threads, then again counting allocations.
+template <typename Plot>
+static long long run_steady_state(double origin, double end, Plot plot)
+{
+    const double span = (end - origin) * 0.05;
+    long long allocations = 0;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int f = 0; f < STEADY_FRAMES; ++f)
+        {
+            const double x_min = origin + span * f / 3.0;
+            const FrameStats stats = run_plot_frame(x_min, x_min + span, plot);
+            if (pass == 1)
+                allocations += stats.allocations;
+        }
+    }
+    return allocations;
+}
+
+template <typename Timeline>
+static long long run_steady_state(const Timeline& timeline, ImPlotBarGroupsFlags flags)
+{
+    return run_steady_state((double)timeline.origin, (double)timeline.end(), [&]() { plot_bar_stack("lane", timeline, 0.5, 0, flags | ImPlotBarGroupsFlags_Horizontal); });
+}
+
+enum BenchEnum : int
+{
+    BenchEnum_Idle,
+    BenchEnum_Run,
+    BenchEnum_Wait,
+    BenchEnum_Stop
+};
+
+// Plots one segment per state of an int backed enum and returns how many colors they got, one per state unless the
+// enum states are mistaken for signed integers
+static int plot_enum_colors()
+{
+    static const double    lengths[4] = { 10, 10, 10, 10 };
+    static const BenchEnum states[4] = { BenchEnum_Idle, BenchEnum_Run, BenchEnum_Wait, BenchEnum_Stop };
+    std::vector<ImU32> colors;
+    run_plot_frame(0, 40, [&]()
+    {
+        ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+        const int vtx_before = draw_list.VtxBuffer.Size;
+        plot_bar_stack("enum", lengths, states, 4, 0.5, 0, ImPlotBarGroupsFlags_Horizontal);
+        for (int i = vtx_before; i < draw_list.VtxBuffer.Size; ++i)
+            colors.push_back(draw_list.VtxBuffer[i].col);
+    });
+    std::sort(colors.begin(), colors.end());
+    return (int)(std::unique(colors.begin(), colors.end()) - colors.begin());
+}
+
+// Plots a negative, a zero and a positive state of type T and returns the color of each segment
+template <typename T>
+static std::vector<ImU32> plot_sign_colors()
+{
+    static const double lengths[3] = { 10, 10, 10 };
+    static const T      states[3] = { (T)-5, (T)0, (T)7 };
+    std::vector<ImU32> colors;
+    run_plot_frame(0, 30, [&]()
+    {
+        ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+        const int vtx_before = draw_list.VtxBuffer.Size;
+        plot_bar_stack("signed", lengths, states, 3, 0.5, 0, ImPlotBarGroupsFlags_Horizontal);
+        for (int i = vtx_before; i < draw_list.VtxBuffer.Size; i += 4)
+            colors.push_back(draw_list.VtxBuffer[i].col);
+    });
+    return colors;
+}
+
+// Returns the number of signed integer types whose states are not colored like int, by their sign in three colors
+static int check_sign_colors()
+{
+    const std::vector<ImU32> expected = plot_sign_colors<int>();
+    const std::vector<ImU32> colors[] = { plot_sign_colors<ImS8>(), plot_sign_colors<ImS16>(), plot_sign_colors<ImS64>(), plot_sign_colors<long>() };
+    int wrong = expected.size() != 3 || expected[0] == expected[1] || expected[1] == expected[2] || expected[0] == expected[2];
+    for (const std::vector<ImU32>& c : colors)
+        wrong += c != expected;
+    return wrong;
+}
+
+// Rasterises bars covering column centers, thin bars, bars past both ends of the row and overlapping bars into a row
+// of 8 pixels starting at x = 100, and returns the number of pixels that differ from the expected ones
+static int check_strip_raster()
+{
+    const ImU32 untouched = IM_COL32(1, 2, 3, 4);
+    const ImU32 a = IM_COL32(255, 0, 0, 255);
+    const ImU32 b = IM_COL32(0, 255, 0, 255);
+    const ImU32 c = IM_COL32(0, 0, 255, 255);
+    const ImU32 d = IM_COL32(255, 255, 0, 255);
+    const float px_min[] = {  96.0f, 102.6f, 102.6f, 104.5f, 104.2f, 106.9f };
+    const float px_max[] = { 101.6f, 102.9f, 104.4f, 105.5f, 105.2f, 120.0f };
+    const ImU32 colors[] = { a,      b,      c,      d,      a,      b      };
+    // [96, 101.6) covers the centers of columns 0 and 1, [102.6, 102.9) covers no center and takes the column it starts in,
+    // [102.6, 104.4) covers the center of column 3 only, [104.5, 105.5) covers that of column 4, where [104.2, 105.2)
+    // overrides it, and [106.9, 120) covers column 7 and is clipped to the row. Columns 5 and 6 keep their pixels.
+    const ImU32 expected[8] = { a, a, b, c, a, untouched, untouched, b };
+    ImU32 row[8];
+    for (ImU32& pixel : row)
+        pixel = untouched;
+    rasterize_bar_stack_strip(px_min, px_max, colors, IM_ARRAYSIZE(colors), 100.0f, IM_ARRAYSIZE(row), row);
+    int wrong = 0;
+    for (int i = 0; i < IM_ARRAYSIZE(row); ++i)
+        wrong += row[i] != expected[i];
+    return wrong;
+}
+
+// Mixes append() and push_transition() and returns the number of segments that do not start, last and hold the state
+// expected: a sample after append() extends the appended segment up to it, there is no gap between segments
+static int check_push_transition()
+{
+    BarStackTimeline<ImU8> timeline;
+    timeline.append(10, 1);
+    timeline.push_transition(50, 2); // extends [0, 10) to 50, opens 2
+    timeline.push_transition(60, 2);
+    timeline.append(5, 3);
+    timeline.push_transition(70, 3); // same state, only extends
+    timeline.push_transition(65, 1); // late, clamped to 70
+    static const uint64_t starts[4]    = {  0, 50, 60, 70 };
+    static const uint64_t durations[4] = { 50, 10, 10,  0 };
+    static const ImU8     states[4]    = {  1,  2,  3,  1 };
+    if (timeline.count() != 4)
+        return 1 + abs(timeline.count() - 4);
+    int wrong = 0;
+    for (int i = 0; i < 4; ++i)
+        wrong += timeline.starts[i] != starts[i] || timeline.durations[i] != durations[i] || timeline.states[i] != states[i];
+    return wrong;
+}
+
+// Builds a pyramid while mixing appends, transitions, repeated timestamps and segments that outgrow their bins, and
+// returns the number of runs that differ from those of the same segments appended to a new timeline before
+// enable_pyramid(). Levels skipped in either are not compared, at least one level must be.
+static int check_incremental_pyramid()
+{
+    BarStackTimeline<ImU8> incremental(1000);
+    incremental.enable_pyramid(4);
+    unsigned int seed = 777;
+    for (int i = 0; i < 20000; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const ImU8 state = (ImU8)((seed >> 8) % 4);
+        const unsigned int pick = seed >> 28;
+        if (pick < 3)
+            incremental.append(1 + pick, state);
+        else if (pick < 5)
+            incremental.push_transition(incremental.end(), state); // zero length, or extends nothing
+        else if (pick < 6)
+            incremental.push_transition(incremental.end() + 200 + (seed >> 16) % 400, state); // outgrows the finer bins
+        else
+            incremental.push_transition(incremental.end() + (seed >> 20) % 8, state);
+    }
+    BarStackTimeline<ImU8> rebuilt(incremental.origin);
+    for (int i = 0; i < incremental.count(); ++i)
+        rebuilt.append(incremental.durations[i], incremental.states[i]);
+    rebuilt.enable_pyramid(4);
+    const BarStackPyramid& a = incremental.pyramid;
+    const BarStackPyramid& b = rebuilt.pyramid;
+    if (a.level_count != b.level_count)
+        return 1;
+    int wrong = 0;
+    int compared = 0;
+    for (int l = 0; l < a.level_count; ++l)
+    {
+        if (a.levels[l].skipped || b.levels[l].skipped)
+            continue;
+        compared++;
+        const ImVector<BarStackPyramidRun>& runs_a = a.levels[l].runs;
+        const ImVector<BarStackPyramidRun>& runs_b = b.levels[l].runs;
+        if (runs_a.Size != runs_b.Size)
+        {
+            wrong += 1 + abs(runs_a.Size - runs_b.Size);
+            continue;
+        }
+        for (int r = 0; r < runs_a.Size; ++r)
+        {
+            const BarStackPyramidRun& ra = runs_a[r];
+            const BarStackPyramidRun& rb = runs_b[r];
+            bool same = ra.start == rb.start && ra.end == rb.end && ra.bin == rb.bin && ra.first == rb.first && ra.color_count == rb.color_count;
+            for (int c = 0; same && c < ra.color_count; ++c)
+                same = ra.colors[c] == rb.colors[c] && fabsf(ra.weights[c] - rb.weights[c]) <= 1e-3f * ImMax(1.0f, rb.weights[c]);
+            wrong += !same;
+        }
+    }
+    return wrong + (compared == 0);
+}
+
+// Packs three blocks and a tail of signed states, including both ends of their range, and durations up to ones that
+// wrap the start times around, then returns the number of segments that do not decode to what was appended
+static int check_compressed_round_trip()
+{
+    static const int count = 3 * BAR_STACK_BLOCK_SEGMENTS + 17;
+    std::vector<uint64_t> durations(count);
+    std::vector<ImS16> states(count);
+    unsigned int seed = 4242;
+    for (int i = 0; i < count; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        durations[i] = 1 + (seed >> 24);
+        states[i] = (ImS16)(seed >> 8);
+    }
+    states[0] = -32768;
+    states[1] = 32767;
+    states[BAR_STACK_BLOCK_SEGMENTS - 1] = -1;            // last of a block
+    states[BAR_STACK_BLOCK_SEGMENTS] = 0;                 // first of the next one
+    durations[BAR_STACK_BLOCK_SEGMENTS + 5] = (1ull << 63) + 12345;
+    durations[2 * BAR_STACK_BLOCK_SEGMENTS] = UINT64_MAX - 7; // the start times wrap around
+    durations[count - 1] = 0;
+    const uint64_t origin = 1000;
+    BarStackCompressedTimeline<ImS16> compressed(origin);
+    for (int i = 0; i < count; ++i)
+        compressed.append(durations[i], states[i]);
+    if (compressed.count() != count || compressed.blocks.Size != 3 || compressed.tail_durations.Size != 17)
+        return 1;
+    int wrong = 0;
+    uint64_t start = origin;
+    uint64_t block_starts[BAR_STACK_BLOCK_SEGMENTS];
+    uint64_t block_durations[BAR_STACK_BLOCK_SEGMENTS];
+    ImS16 block_states[BAR_STACK_BLOCK_SEGMENTS];
+    for (int b = 0; b < compressed.blocks.Size; ++b)
+    {
+        compressed.decode(b, block_starts, block_durations, block_states);
+        for (int k = 0; k < BAR_STACK_BLOCK_SEGMENTS; ++k)
+        {
+            const int i = b * BAR_STACK_BLOCK_SEGMENTS + k;
+            wrong += block_starts[k] != start || block_durations[k] != durations[i] || block_states[k] != states[i];
+            start += durations[i];
+        }
+    }
+    wrong += compressed.tail_start != start;
+    for (int k = 0; k < compressed.tail_durations.Size; ++k)
+    {
+        const int i = compressed.blocks.Size * BAR_STACK_BLOCK_SEGMENTS + k;
+        wrong += compressed.tail_durations[k] != durations[i] || compressed.tail_states[k] != states[i];
+        start += durations[i];
+    }
+    wrong += compressed.end() != start;
+    return wrong;
+}
+
+// Fills a small ingest queue past its capacity from one thread, then has several producers retrying try_push() while the
+// consumer pops, and returns the number of counters and transitions that are off: push() on a full queue is dropped,
+// try_push() is counted as full and nothing is lost, and the transitions of each producer come out in their order
+static int check_ingest()
+{
+    int wrong = 0;
+    {
+        BarStackIngestQueue<ImU8> queue(64);
+        for (int i = 0; i < queue.capacity(); ++i)
+            wrong += !queue.push(10 * (uint64_t)(i + 1), (ImU8)(i % 2));
+        wrong += queue.push(10000, 0);
+        wrong += queue.try_push(10000, 0);
+        wrong += queue.try_push(10000, 0);
+        wrong += queue.pushed_count() != (uint64_t)queue.capacity() || queue.dropped_count() != 1 || queue.full_count() != 2;
+        BarStackTimeline<ImU8> timeline;
+        wrong += queue.drain(timeline) != queue.capacity() || timeline.count() != queue.capacity() || queue.max_fill() != queue.capacity();
+        wrong += timeline.starts[1] != 20 || timeline.end() != 10 * (uint64_t)queue.capacity();
+        wrong += !queue.try_push(10000, 0) || queue.full_count() != 2;
+    }
+    static const int producer_count = 4;
+    static const int transitions = 20000;
+    BarStackIngestQueue<ImU32> queue(256);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producer_count; ++p)
+    {
+        producers.emplace_back([&queue, p]()
+        {
+            for (int i = 1; i <= transitions; ++i)
+            {
+                while (!queue.try_push((uint64_t)i, (ImU32)p))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    uint64_t last[producer_count] = {};
+    int received = 0;
+    while (received < producer_count * transitions)
+    {
+        BarStackTransition<ImU32> transition;
+        if (!queue.pop(&transition))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        received++;
+        if (transition.state >= (ImU32)producer_count)
+        {
+            wrong++;
+            continue;
+        }
+        wrong += transition.timestamp != last[transition.state] + 1;
+        last[transition.state] = transition.timestamp;
+    }
+    for (std::thread& producer : producers)
+        producer.join();
+    BarStackTransition<ImU32> extra;
+    wrong += queue.pop(&extra);
+    wrong += queue.dropped_count() != 0 || queue.pushed_count() != (uint64_t)(producer_count * transitions);
+    return wrong;
+}
+
+// Writes two lanes into a capture file, opens it and returns the number of columns, origins and versions that did not
+// come back: every column must match, and the views of each lane and of each opening must have versions of their own
+static int check_capture_round_trip()
+{
+    static const char* path = "bar_stack_capture_check.bin";
+    static const char* names[2] = { "first", "second" };
+    BarStackTimeline<ImU16> first(1000);
+    BarStackTimeline<ImU16> second(5000);
+    for (int i = 0; i < 100; ++i)
+        first.append(1 + i % 7, (ImU16)(i % 5));
+    second.append(3, 1);
+    second.push_transition(5010, 2);
+    second.push_transition(5020, 2);
+    const BarStackTimeline<ImU16>* lanes[2] = { &first, &second };
+    if (!write_bar_stack_capture(path, lanes, names, 2))
+        return 1;
+    int wrong = 0;
+    uint64_t versions[2] = {};
+    for (int open = 0; open < 2; ++open)
+    {
+        BarStackCaptureFile file;
+        if (!file.open(path) || file.lane_count() != 2 || file.state_size() != (int)sizeof(ImU16))
+        {
+            wrong++;
+            break;
+        }
+        wrong += file.view<ImU8>(0).count() != 0; // another state size
+        for (int l = 0; l < 2; ++l)
+        {
+            const BarStackTimeline<ImU16>& lane = *lanes[l];
+            const BarStackTimelineView<ImU16> view = file.view<ImU16>(l);
+            wrong += strcmp(file.lane(l).name, names[l]) != 0;
+            wrong += view.count() != lane.count() || view.origin != lane.origin;
+            for (int i = 0; i < ImMin(view.count(), lane.count()); ++i)
+                wrong += view.starts[i] != lane.starts[i] || view.durations[i] != lane.durations[i] || view.states[i] != lane.states[i];
+            wrong += view.version == 0 || view.version == versions[0] || view.version == versions[1] || view.version == lane.version;
+            wrong += file.view<ImU16>(l).version != view.version;
+        }
+        versions[0] = file.view<ImU16>(0).version;
+        versions[1] = file.view<ImU16>(1).version;
+        wrong += versions[0] == versions[1];
+    }
+    remove(path);
+    return wrong;
+}
+
+// What one plot_bar_stack call added to the draw list
+struct DrawOutput
+{
+    std::vector<ImDrawVert> vtx;
+    std::vector<ImDrawIdx>  idx;
+    std::vector<ImDrawCmd>  cmds; // from the command the call started in
+};
+
+// Plots a lane without level of detail, with more vertices than 16 bit indices address, serially then in parallel, and
+// returns the number of vertices, indices and draw commands that differ, or 1 when the lane did not split draw commands
+static int check_parallel_render()
+{
+    BarStackTimeline<ImU8> lane;
+    build_lane(lane, 100000);
+    static const char* labels[2] = { "serial", "parallel" };
+    const ImPlotBarGroupsFlags flags[2] = {
+        BarStackFlags_NoLod | ImPlotBarGroupsFlags_Horizontal,
+        BarStackFlags_NoLod | BarStackFlags_Parallel | ImPlotBarGroupsFlags_Horizontal
+    };
+    DrawOutput outputs[2];
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        DrawOutput& out = outputs[pass];
+        run_plot_frame((double)lane.origin, (double)lane.end(), [&]()
+        {
+            const ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+            const int vtx_before = draw_list.VtxBuffer.Size;
+            const int idx_before = draw_list.IdxBuffer.Size;
+            const int cmd_before = draw_list.CmdBuffer.Size - 1;
+            plot_bar_stack(labels[pass], lane, 0.5, 0, flags[pass]);
+            out.vtx.assign(draw_list.VtxBuffer.begin() + vtx_before, draw_list.VtxBuffer.end());
+            out.idx.assign(draw_list.IdxBuffer.begin() + idx_before, draw_list.IdxBuffer.end());
+            out.cmds.assign(draw_list.CmdBuffer.begin() + cmd_before, draw_list.CmdBuffer.end());
+        });
+    }
+    const DrawOutput& serial = outputs[0];
+    const DrawOutput& parallel = outputs[1];
+    int wrong = 0;
+    if (sizeof(ImDrawIdx) == 2 && serial.cmds.size() < 2)
+        wrong++;
+    if (serial.vtx.size() != parallel.vtx.size() || serial.idx.size() != parallel.idx.size() || serial.cmds.size() != parallel.cmds.size())
+        return wrong + 1;
+    for (size_t i = 0; i < serial.vtx.size(); ++i)
+        wrong += memcmp(&serial.vtx[i], &parallel.vtx[i], sizeof(ImDrawVert)) != 0;
+    for (size_t i = 0; i < serial.idx.size(); ++i)
+        wrong += serial.idx[i] != parallel.idx[i];
+    for (size_t i = 0; i < serial.cmds.size(); ++i)
+        wrong += serial.cmds[i].ElemCount != parallel.cmds[i].ElemCount || serial.cmds[i].IdxOffset != parallel.cmds[i].IdxOffset ||
+            serial.cmds[i].VtxOffset != parallel.cmds[i].VtxOffset;
+    return wrong;
+}
+
+// Plots lengths and states with and without BarStackFlags_Follow over the frames of one step and returns the number of
+// vertices of the last frame that differ: same color, and positions within a tenth of a pixel. raw picks the raw array overload.
+static int compare_follow_frames(const std::vector<double>& lengths, const std::vector<ImU8>& states, bool raw)
+{
+    double end = 0;
+    for (double length : lengths)
+        end += length;
+    std::vector<ImDrawVert> outputs[2];
+    for (int f = 0; f < 3; ++f)
+    {
+        run_plot_frame(0, end, [&]()
+        {
+            ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                const ImPlotBarGroupsFlags flags = ImPlotBarGroupsFlags_Horizontal | (pass == 1 ? BarStackFlags_Follow : 0);
+                const char* label = pass == 1 ? "follow" : "plain";
+                const int vtx_before = draw_list.VtxBuffer.Size;
+                if (raw)
+                    plot_bar_stack(label, lengths.data(), states.data(), (int)lengths.size(), 0.5, 0, flags);
+                else
+                    plot_bar_stack(label, lengths.data(), states, (int)lengths.size(), 0.5, 0, flags);
+                outputs[pass].assign(draw_list.VtxBuffer.begin() + vtx_before, draw_list.VtxBuffer.end());
+            }
+        });
+    }
+    if (outputs[0].size() != outputs[1].size())
+        return 1 + (int)std::max(outputs[0].size(), outputs[1].size());
+    int wrong = 0;
+    for (size_t i = 0; i < outputs[0].size(); ++i)
+    {
+        const ImDrawVert& plain = outputs[0][i];
+        const ImDrawVert& follow = outputs[1][i];
+        wrong += plain.col != follow.col || fabsf(plain.pos.x - follow.pos.x) > 0.1f || fabsf(plain.pos.y - follow.pos.y) > 0.1f;
+    }
+    return wrong;
+}
+
+// Checks that BarStackFlags_Follow draws the bars of the plain path for lengths that are plotted, appended to, and then
+// refilled in place with other first and last entries, from a std::vector and from a raw array.
+// Returns the number of vertices that differ.
+static int check_follow()
+{
+    int wrong = 0;
+    for (int raw = 0; raw < 2; ++raw)
+    {
+        std::vector<double> lengths;
+        std::vector<ImU8> states;
+        for (int i = 0; i < 500; ++i)
+        {
+            lengths.push_back(1 + i % 7);
+            states.push_back((ImU8)(i % 5));
+        }
+        wrong += compare_follow_frames(lengths, states, raw != 0);
+        for (int i = 0; i < 50; ++i)
+        {
+            lengths.push_back(2);
+            states.push_back((ImU8)(i % 3));
+        }
+        wrong += compare_follow_frames(lengths, states, raw != 0);
+        // same arrays, same count, new contents
+        for (size_t i = 0; i < lengths.size(); ++i)
+            states[i] = (ImU8)((i + 2) % 5);
+        wrong += compare_follow_frames(lengths, states, raw != 0);
+    }
+    return wrong;
+}
+
+// Pans and holds a view over the columns of a lane, then the lane itself, and returns the number of frames that looked for
+// runs of one color outside the allowed window: a view, whose columns may be mapped from a file, is never scanned, and a
+// timeline scans at most one view width to each side of the visible segments
+static int check_run_scans()
+{
+    BarStackTimeline<ImU8> lane;
+    build_lane(lane, 100000);
+    BarStackTimelineView<ImU8> view;
+    view.starts = lane.starts.Data;
+    view.durations = lane.durations.Data;
+    view.states = lane.states.Data;
+    view.segments = lane.count();
+    view.origin = lane.origin;
+    view.version = next_bar_stack_version();
+    const double span = (double)(lane.end() - lane.origin) * 0.01;
+    int wrong = 0;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int f = 0; f < 2 * STEADY_FRAMES; ++f)
+        {
+            // every other frame holds the view of the previous one
+            const double x_min = lane.origin + span * (f / 2) / 3.0;
+            run_plot_frame(x_min, x_min + span, [&]()
+            {
+                if (pass == 0)
+                    plot_bar_stack("view", view, 0.5, 0, ImPlotBarGroupsFlags_Horizontal);
+                else
+                    plot_bar_stack("lane", lane, 0.5, 0, ImPlotBarGroupsFlags_Horizontal);
+            });
+            const BarStackStats& stats = get_bar_stack_stats().back();
+            const int visible = stats.segments - stats.segments_hidden;
+            wrong += pass == 0 ? stats.segments_scanned != 0 : stats.segments_scanned > 3 * visible + 1;
+        }
+    }
+    return wrong;
+}
+
+// CPU copies of the textures the strips upload, a texture id is its index + 1
+static std::vector<std::vector<ImU32>> g_textures;
+static std::vector<int> g_texture_widths;
+static int g_texture_updates = 0;
+
+static ImTextureID create_texture(int width, int height, const ImU32* pixels)
+{
+    g_textures.emplace_back(pixels, pixels + (size_t)width * height);
+    g_texture_widths.push_back(width);
+    return (ImTextureID)(intptr_t)g_textures.size();
+}
+
+static void update_texture(ImTextureID texture, int y, int width, int height, const ImU32* pixels)
+{
+    std::vector<ImU32>& copy = g_textures[(intptr_t)texture - 1];
+    const int texture_width = g_texture_widths[(intptr_t)texture - 1];
+    for (int row = 0; row < height; ++row)
+        memcpy(&copy[(size_t)(y + row) * texture_width], pixels + (size_t)row * texture_width, width * sizeof(ImU32));
+    g_texture_updates++;
+}
+
+static void destroy_texture(ImTextureID texture)
+{
+    g_textures[(intptr_t)texture - 1].clear();
+}
+
+// Pans a strip lane by whole pixels at one time unit per pixel and returns the number of screen columns whose texel
+// differs from the one the previous frame showed at the same time, plus one when the row was rasterised again on more
+// than one frame in eight: panning only moves the texture coordinates of the quad until the view leaves the row
+static int check_strip_pan()
+{
+    BarStackTextureBackend backend;
+    backend.create = create_texture;
+    backend.update = update_texture;
+    backend.destroy = destroy_texture;
+    set_bar_stack_texture_backend(backend);
+    BarStackTimeline<ImU8> lane;
+    build_lane(lane, 100000);
+    const int pan = 37;
+    double span = 1000;
+    std::vector<ImU32> previous;
+    std::vector<ImU32> columns;
+    int wrong = 0;
+    int updates = 0;
+    for (int f = 0; f < STEADY_FRAMES; ++f)
+    {
+        const double x_min = lane.origin + 1000.0 + (double)pan * f;
+        const int updates_before = g_texture_updates;
+        run_plot_frame(x_min, x_min + span, [&]()
+        {
+            const ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+            const ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+            const int vtx_before = draw_list.VtxBuffer.Size;
+            plot_bar_stack("strip", lane, 0.5, 0, BarStackFlags_Strip | ImPlotBarGroupsFlags_Horizontal);
+            const int width = (int)ceilf(plot.PlotRect.GetWidth());
+            // the first frame sets the zoom to one time unit per pixel for the others
+            span = width;
+            columns.clear();
+            if (draw_list.VtxBuffer.Size - vtx_before != 4)
+                return;
+            // the atlas is the last texture created
+            const std::vector<ImU32>& pixels = g_textures.back();
+            const int texture_width = g_texture_widths.back();
+            const ImVec2 uv = draw_list.VtxBuffer[vtx_before].uv;
+            const int row = (int)(uv.y * pixels.size() / texture_width);
+            for (int c = 0; c < width; ++c)
+                columns.push_back(pixels[(size_t)row * texture_width + (int)(uv.x * texture_width + c + 0.5f)]);
+        });
+        if (f >= 2)
+        {
+            updates += g_texture_updates - updates_before;
+            if (columns.size() != previous.size())
+                return wrong + 1;
+            for (size_t c = 0; c + pan < columns.size(); ++c)
+                wrong += columns[c] != previous[c + pan];
+        }
+        previous.swap(columns);
+    }
+    set_bar_stack_texture_backend(BarStackTextureBackend());
+    return wrong + (updates * 8 > STEADY_FRAMES);
+}
+
+static BarStackTimeline<ImU8>* g_nested_lane = nullptr;
+
+// Texture update that plots another stack, from inside the plot_bar_stack call that rasterises a strip
+static void update_texture_nested(ImTextureID texture, int y, int width, int height, const ImU32* pixels)
+{
+    update_texture(texture, y, width, height, pixels);
+    plot_bar_stack("inner", *g_nested_lane, 1.5, 0, ImPlotBarGroupsFlags_Horizontal);
+}
+
+// Plots a strip whose texture update plots another stack, once the stats of the frame fill their capacity so the inner
+// call reallocates them, and returns the number of counters of the outer call that were lost
+static int check_nested_stats()
+{
+    BarStackTextureBackend backend;
+    backend.create = create_texture;
+    backend.update = update_texture_nested;
+    backend.destroy = destroy_texture;
+    set_bar_stack_texture_backend(backend);
+    BarStackTimeline<ImU8> lane;
+    build_lane(lane, 1000);
+    BarStackTimeline<ImU8> inner;
+    build_lane(inner, 100);
+    g_nested_lane = &inner;
+    int wrong = 0;
+    run_plot_frame((double)lane.origin, (double)lane.end(), [&]()
+    {
+        plot_bar_stack("fill", inner, 2.5, 0, ImPlotBarGroupsFlags_Horizontal);
+        while (get_bar_stack_stats().Size < get_bar_stack_stats().Capacity)
+            plot_bar_stack("fill", inner, 2.5, 0, ImPlotBarGroupsFlags_Horizontal);
+        const int outer = get_bar_stack_stats().Size;
+        plot_bar_stack("outer", lane, 0.5, 0, BarStackFlags_Strip | ImPlotBarGroupsFlags_Horizontal);
+        // the outer call comes before the inner one, and its counters went on after the inner call returned
+        plot_bar_stack("after", inner, 3.5, 0, ImPlotBarGroupsFlags_Horizontal);
+        const ImVector<BarStackStats>& stats = get_bar_stack_stats();
+        if (stats.Size != outer + 3)
+            wrong++;
+        else
+        {
+            wrong += strcmp(stats[outer].label, "outer") != 0 || strcmp(stats[outer + 1].label, "inner") != 0;
+            wrong += stats[outer].segments_hidden == stats[outer].segments;
+            wrong += stats[outer].elapsed_ms < stats[outer + 1].elapsed_ms;
+            wrong += stats[outer + 1].vtx_reserved == 0;
+        }
+    });
+    g_nested_lane = nullptr;
+    set_bar_stack_texture_backend(BarStackTextureBackend());
+    return wrong;
+}
+
+int main(int, char**)
+{
+    IMGUI_CHECKVERSION();
+    ImGui::SetAllocatorFunctions(counting_alloc, counting_free, nullptr);
+    ImGui::CreateContext();
+    ImPlot::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = DISPLAY_SIZE;
+    io.DeltaTime = 1.0f / 60.0f;
+    io.IniFilename = nullptr;
+    // as with a renderer backend drawing with vertex offsets, so large stacks split draw commands instead of wrapping 16 bit indices
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+    // no renderer backend, the font atlas only has to be built once
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    static const int    segment_counts[] = { 1000, 10000, 100000, 1000000, 10000000 };
+    static const double zooms[] = { 1.0, 0.1, 0.001 };
+    static const int    max_nolod_segments = 1000000; // beyond that every frame emits hundreds of MB of vertices
+
+    printf("%-8s %10s %10s %12s %12s %10s %8s %10s\n", "mode", "segments", "zoom", "ns/segment", "us/plot", "vertices", "cmds", "allocs");
+    BarStackTimeline<ImU8> timeline;
+    BarStackCompressedTimeline<ImU8> compressed;
+    for (int count : segment_counts)
+    {
+        build_lane(timeline, count);
+        for (int mode = 0; mode < BenchMode_COUNT; ++mode)
+        {
+            if (mode == BenchMode_NoLod && count > max_nolod_segments)
+                continue;
+            if (mode == BenchMode_Compressed)
+            {
+                compressed.clear();
+                for (int i = 0; i < count; ++i)
+                    compressed.append(timeline.durations[i], timeline.states[i]);
+                const size_t plain_bytes = timeline.starts.size_in_bytes() + timeline.durations.size_in_bytes() + timeline.states.size_in_bytes();
+                printf("# %d segments: %zu bytes plain, %zu bytes compressed\n", count, plain_bytes, compressed.memory_size());
+                for (double zoom : zooms)
+                    run_case(compressed, mode, zoom);
+                continue;
+            }
+            if (mode == BenchMode_Pyramid)
+            {
+                // a lane of its own: clear() keeps the pyramid enabled, it would be built and plotted by every later case
+                BarStackTimeline<ImU8> pyramid_lane;
+                build_lane(pyramid_lane, count);
+                pyramid_lane.enable_pyramid(1);
+                for (double zoom : zooms)
+                    run_case(pyramid_lane, mode, zoom);
+                continue;
+            }
+            for (double zoom : zooms)
+                run_case(timeline, mode, zoom);
+        }
+    }
+
+    BarStackTimeline<ImU8> steady;
+    build_lane(steady, 1000000);
+    compressed.clear();
+    for (int i = 0; i < steady.count(); ++i)
+        compressed.append(steady.durations[i], steady.states[i]);
+    struct SteadyCase { const char* name; ImPlotBarGroupsFlags flags; bool compressed; };
+    static const SteadyCase steady_cases[] = {
+        { "lod",      0,                                               false },
+        { "nolod",    BarStackFlags_NoLod,                             false },
+        { "parallel", BarStackFlags_NoLod | BarStackFlags_Parallel,    false },
+        { "follow",   BarStackFlags_Follow,                            false },
+        { "packed",   0,                                               true  },
+    };
+    int failures = 0;
+    printf("\n%-8s %10s\n", "steady", "allocs");
+    for (const SteadyCase& c : steady_cases)
+    {
+        const long long allocations = c.compressed ? run_steady_state(compressed, c.flags) : run_steady_state(steady, c.flags);
+        printf("%-8s %10lld%s\n", c.name, allocations, allocations == 0 ? "" : "  FAILED");
+        if (allocations != 0)
+            failures++;
+    }
+    // the overloads reading raw lengths, from a raw array, a std::vector or with a std::string label kept across frames
+    std::vector<double> steady_lengths(steady.count());
+    std::vector<ImU8> steady_states(steady.count());
+    for (int i = 0; i < steady.count(); ++i)
+    {
+        steady_lengths[i] = (double)steady.durations[i];
+        steady_states[i] = steady.states[i];
+    }
+    const std::string steady_label = "lane";
+    const double steady_end = (double)(steady.end() - steady.origin);
+    const int steady_count = steady.count();
+    const long long raw_allocations[3] = {
+        run_steady_state(0.0, steady_end, [&]() { plot_bar_stack("lane", steady_lengths.data(), steady_states.data(), steady_count, 0.5, 0, ImPlotBarGroupsFlags_Horizontal); }),
+        run_steady_state(0.0, steady_end, [&]() { plot_bar_stack("lane", steady_lengths.data(), steady_states, steady_count, 0.5, 0, ImPlotBarGroupsFlags_Horizontal); }),
+        run_steady_state(0.0, steady_end, [&]() { plot_bar_stack(steady_label, steady_lengths.data(), steady_states, steady_count, 0.5, 0, ImPlotBarGroupsFlags_Horizontal); }),
+    };
+    static const char* raw_names[3] = { "raw", "vector", "string" };
+    for (int i = 0; i < 3; ++i)
+    {
+        printf("%-8s %10lld%s\n", raw_names[i], raw_allocations[i], raw_allocations[i] == 0 ? "" : "  FAILED");
+        if (raw_allocations[i] != 0)
+            failures++;
+    }
+
+    const ImU32 rebuilt_colors[2] = { plot_rebuilt_timeline(0), plot_rebuilt_timeline(1) };
+    const bool rebuilt_replayed = rebuilt_colors[0] == rebuilt_colors[1];
+    printf("\nrebuilt timeline %s\n", rebuilt_replayed ? "replayed stale vertices  FAILED" : "ok");
+    if (rebuilt_replayed)
+        failures++;
+
+    const int enum_colors = plot_enum_colors();
+    printf("enum states %d colors%s\n", enum_colors, enum_colors == 4 ? "" : "  FAILED");
+    if (enum_colors != 4)
+        failures++;
+
+    const int sign_wrong = check_sign_colors();
+    printf("signed states %d types unlike int%s\n", sign_wrong, sign_wrong == 0 ? "" : "  FAILED");
+    if (sign_wrong != 0)
+        failures++;
+
+    const int strip_wrong = check_strip_raster();
+    printf("strip raster %d wrong pixels%s\n", strip_wrong, strip_wrong == 0 ? "" : "  FAILED");
+    if (strip_wrong != 0)
+        failures++;
+
+    const int transition_wrong = check_push_transition();
+    printf("push transition %d wrong segments%s\n", transition_wrong, transition_wrong == 0 ? "" : "  FAILED");
+    if (transition_wrong != 0)
+        failures++;
+
+    const int pyramid_wrong = check_incremental_pyramid();
+    printf("incremental pyramid %d runs unlike the rebuilt ones%s\n", pyramid_wrong, pyramid_wrong == 0 ? "" : "  FAILED");
+    if (pyramid_wrong != 0)
+        failures++;
+
+    const int compressed_wrong = check_compressed_round_trip();
+    printf("compressed round trip %d wrong%s\n", compressed_wrong, compressed_wrong == 0 ? "" : "  FAILED");
+    if (compressed_wrong != 0)
+        failures++;
+
+    const int ingest_wrong = check_ingest();
+    printf("ingest %d wrong%s\n", ingest_wrong, ingest_wrong == 0 ? "" : "  FAILED");
+    if (ingest_wrong != 0)
+        failures++;
+
+    const int capture_wrong = check_capture_round_trip();
+    printf("capture round trip %d wrong%s\n", capture_wrong, capture_wrong == 0 ? "" : "  FAILED");
+    if (capture_wrong != 0)
+        failures++;
+
+    const int follow_wrong = check_follow();
+    printf("follow %d vertices unlike the plain bars%s\n", follow_wrong, follow_wrong == 0 ? "" : "  FAILED");
+    if (follow_wrong != 0)
+        failures++;
+
+    const int parallel_wrong = check_parallel_render();
+    printf("parallel render %d differences%s\n", parallel_wrong, parallel_wrong == 0 ? "" : "  FAILED");
+    if (parallel_wrong != 0)
+        failures++;
+
+    const int scan_wrong = check_run_scans();
+    printf("run scans %d frames outside the window%s\n", scan_wrong, scan_wrong == 0 ? "" : "  FAILED");
+    if (scan_wrong != 0)
+        failures++;
+
+    const int strip_pan_wrong = check_strip_pan();
+    printf("strip pan %d wrong%s\n", strip_pan_wrong, strip_pan_wrong == 0 ? "" : "  FAILED");
+    if (strip_pan_wrong != 0)
+        failures++;
+
+    const int nested_wrong = check_nested_stats();
+    printf("nested stats %d lost%s\n", nested_wrong, nested_wrong == 0 ? "" : "  FAILED");
+    if (nested_wrong != 0)
+        failures++;
+
+    ImPlot::DestroyContext();
+    ImGui::DestroyContext();
+    return failures == 0 ? 0 : 1;
+}
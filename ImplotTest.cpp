@@ -44,6 +44,32 @@ static void glfw_error_callback(int error, const char* description)
     fprintf(stderr, "GLFW Error %d: %s\n", error, description);
 }
 
+// Texture callbacks for BarStackFlags_Strip, uploading the strip atlas through OpenGL like the backend does for the font atlas
+static ImTextureID create_strip_texture(int width, int height, const ImU32* pixels)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    return (ImTextureID)(intptr_t)texture;
+}
+
+static void update_strip_texture(ImTextureID texture, int y, int width, int height, const ImU32* pixels)
+{
+    glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)texture);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
+static void destroy_strip_texture(ImTextureID texture)
+{
+    GLuint id = (GLuint)(intptr_t)texture;
+    glDeleteTextures(1, &id);
+}
+
 void Demo_BarPlots() {
     std::deque<uint64_t> times1 = { 0,5,11,18,26,35,45,56,68,81 };
     std::deque<bool> data1 = { true,false,true,false,true,false,true,false,true,false };
@@ -98,24 +124,26 @@ void Demo_BarPlots() {
 //-----------------------------------------------------------------------------
 
 void Demo_BarGroups() {
-    std::deque<uint64_t>  times = { 0,10,15,16,19,21,23,25,29,30 };
-    std::deque<bool> data1 = { true,false,true,false,true,false,true,false,true,false };
-    std::vector<uint64_t> datas(times.size() - 1);
-    std::vector<bool> data_values(times.size() - 1);
-    for (size_t i = 0; i < times.size() - 1; ++i)
+    // The timelines are built once and plotted in place every frame
+    static BarStackTimeline<bool> timeline1;
+    static BarStackTimeline<bool> timeline2;
+    if (timeline1.count() == 0)
     {
-        datas[i] = times[i + 1] - times[i];
-        data_values[i] = data1[i];
-    }
+        std::deque<uint64_t>  times = { 0,10,15,16,19,21,23,25,29,30 };
+        std::deque<bool> data1 = { true,false,true,false,true,false,true,false,true,false };
+        timeline1.reserve(times.size() - 1);
+        for (size_t i = 0; i < times.size() - 1; ++i)
+        {
+            timeline1.append(times[i + 1] - times[i], data1[i]);
+        }
 
-    std::deque<uint64_t>  times2 = { 0,3,10,18,19,24,30 };
-    std::deque<bool> data2 = { false,true,true,false,true,false,true };    
-    std::vector<uint64_t> datas2(times2.size() - 1);
-    std::vector<bool> data_values2(times2.size() - 1);
-    for (size_t i = 0; i < times2.size() - 1; ++i)
-    {
-        datas2[i] = times2[i + 1] - times2[i];
-        data_values2[i] = data2[i];
+        std::deque<uint64_t>  times2 = { 0,3,10,18,19,24,30 };
+        std::deque<bool> data2 = { false,true,true,false,true,false,true };
+        timeline2.reserve(times2.size() - 1);
+        for (size_t i = 0; i < times2.size() - 1; ++i)
+        {
+            timeline2.append(times2[i + 1] - times2[i], data2[i]);
+        }
     }
     static float size = 0.67f;
 
@@ -123,6 +151,9 @@ void Demo_BarGroups() {
 
     //ImGui::CheckboxFlags("Stacked", (unsigned int*)&flags, ImPlotBarGroupsFlags_Stacked);
     //ImGui::SameLine();
+    ImGui::CheckboxFlags("Strip", (unsigned int*)&flags, BarStackFlags_Strip);
+    ImGui::SameLine();
+    ImGui::CheckboxFlags("Follow", (unsigned int*)&flags, BarStackFlags_Follow);
 
 
     if (ImPlot::BeginPlot("Bar Group", ImVec2(-1,0),ImPlotFlags_Equal)) {
@@ -130,20 +161,37 @@ void Demo_BarGroups() {
 
         ImPlot::SetupAxes("Time", "Topic", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
         ImPlot::SetupAxis(ImAxis_Y1, NULL,ImPlotAxisFlags_NoLabel | ImPlotAxisFlags_NoTickLabels);
-        plot_bar_stack("testa", datas.data(), data_values,datas.size(), 0.1, 0, flags | ImPlotBarGroupsFlags_Horizontal | ImPlotBarGroupsFlags_Stacked);
-        plot_bar_stack("testb", datas2.data(), data_values2,datas2.size(), 0.1, 0.2, flags | ImPlotBarGroupsFlags_Horizontal | ImPlotBarGroupsFlags_Stacked);
+        const BarStackTimeline<bool>* lanes[] = { &timeline1, &timeline2 };
+        plot_bar_stack_lanes("topics", lanes, 2, 0.1, 0.2, 0, flags | ImPlotBarGroupsFlags_Horizontal | ImPlotBarGroupsFlags_Stacked);
 
-        for (size_t i = 0; i < data1.size(); ++i)
-        {
-            const char* text = data1[i] ? "TRUE" : "FALSE";
-            ImPlot::PlotText(text, times[i], 0.1f);
-        }
-        for (size_t i = 0; i < data2.size(); ++i)
+        // only the segments wide enough for their text get a label
+        static const char* state_labels[] = { "FALSE", "TRUE" };
+        plot_bar_stack_lanes_labels("topics", lanes, 2, 0.2, 0, state_labels, 2);
+        BarStackHover<bool> hover;
+        if (hover_bar_stack_lanes("topics", lanes, 2, 0.1, 0.2, 0, &hover))
+            show_bar_stack_hover(hover, state_labels, 2);
+
+        ImPlot::EndPlot();
+    }
+}
+
+void Demo_Timestamps() {
+    // Nanosecond epoch timestamps are plotted as they are, relative to the time origin of the plot
+    static uint64_t timestamps[64];
+    static ImU8 states[64];
+    if (timestamps[0] == 0)
+    {
+        const uint64_t epoch = 1700000000000000000ull;
+        for (int i = 0; i < 64; ++i)
         {
-            const char* text = data2[i] ? "TRUE" : "FALSE";
-            ImPlot::PlotText(text, times2[i], 0.3f);
+            timestamps[i] = epoch + i * 250 + (i % 3) * 40; // sub-microsecond segments
+            states[i] = (ImU8)(i % 3);
         }
+    }
 
+    if (ImPlot::BeginPlot("Timestamps", ImVec2(-1, 150))) {
+        ImPlot::SetupAxes("ns since origin", nullptr, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_NoTickLabels);
+        plot_bar_stack_timestamps("transitions", timestamps, states, 64, 0.5, 0, ImPlotBarGroupsFlags_Horizontal);
         ImPlot::EndPlot();
     }
 }
@@ -277,6 +325,11 @@ int main(int, char**)
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImPlot::CreateContext();
+    BarStackTextureBackend strip_backend;
+    strip_backend.create = create_strip_texture;
+    strip_backend.update = update_strip_texture;
+    strip_backend.destroy = destroy_strip_texture;
+    set_bar_stack_texture_backend(strip_backend);
     ImGuiIO& io = ImGui::GetIO(); (void)io;
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
@@ -312,6 +365,7 @@ int main(int, char**)
     // Our state
     bool show_demo_window = true;
     bool show_another_window = false;
+    bool show_bar_stack_stats = false;
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
     // Main loop
@@ -350,6 +404,7 @@ int main(int, char**)
             ImGui::Text("This is some useful text.");               // Display some text (you can use a format strings too)
             ImGui::Checkbox("Demo Window", &show_demo_window);      // Edit bools storing our window open/close state
             ImGui::Checkbox("Another Window", &show_another_window);
+            ImGui::Checkbox("Bar Stack Stats", &show_bar_stack_stats);
 
             ImGui::SliderFloat("float", &f, 0.0f, 1.0f);            // Edit 1 float using a slider from 0.0f to 1.0f
             ImGui::ColorEdit3("clear color", (float*)&clear_color); // Edit 3 floats representing a color
@@ -375,6 +430,9 @@ int main(int, char**)
 
         // 4. Test bar plots
         Demo_BarGroups();
+        Demo_Timestamps();
+        if (show_bar_stack_stats)
+            show_bar_stack_stats_window(&show_bar_stack_stats);
 
 
         // Rendering
@@ -0,0 +1,199 @@
+#include "bar_stack_capture.h"
+#include "implot_internal.h"
+
+#include <stdio.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint64_t align_capture_offset(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+BarStackCaptureFile::BarStackCaptureFile() :
+    data(nullptr),
+    size(0),
+    last_error(nullptr)
+#ifdef _WIN32
+    , file_handle(INVALID_HANDLE_VALUE),
+    mapping_handle(nullptr)
+#else
+    , fd(-1)
+#endif
+{ }
+
+BarStackCaptureFile::~BarStackCaptureFile() {
+    close();
+}
+
+bool BarStackCaptureFile::fail(const char* message) {
+    close();
+    last_error = message;
+    return false;
+}
+
+bool BarStackCaptureFile::open(const char* path) {
+    close();
+#ifdef _WIN32
+    file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE)
+        return fail("can not open file");
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart < (LONGLONG)sizeof(BarStackCaptureHeader))
+        return fail("file too small");
+    size = (size_t)file_size.QuadPart;
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr)
+        return fail("can not map file");
+    data = (const unsigned char*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr)
+        return fail("can not map file");
+#else
+    fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return fail("can not open file");
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(BarStackCaptureHeader))
+        return fail("file too small");
+    size = (size_t)st.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED)
+        return fail("can not map file");
+    data = (const unsigned char*)mapped;
+    // plots read a binary search path and the visible window, read ahead would page in data nobody looks at
+    madvise(mapped, size, MADV_RANDOM);
+#endif
+    const BarStackCaptureHeader& head = header();
+    if (memcmp(head.magic, BAR_STACK_CAPTURE_MAGIC, sizeof(head.magic)) != 0)
+        return fail("not a capture file");
+    if (head.version != BAR_STACK_CAPTURE_VERSION)
+        return fail("unsupported capture version");
+    if (head.file_size != size)
+        return fail("truncated capture file");
+    if (head.state_size != 1 && head.state_size != 2 && head.state_size != 4 && head.state_size != 8)
+        return fail("invalid state size");
+    if (head.lane_count > (size - sizeof(BarStackCaptureHeader)) / sizeof(BarStackCaptureLane))
+        return fail("invalid lane table");
+    // the columns are checked against the file size without reading them
+    for (int i = 0; i < (int)head.lane_count; ++i) {
+        const BarStackCaptureLane& l = lane(i);
+        if (l.count > INT32_MAX)
+            return fail("too many segments in a lane");
+        const uint64_t columns[3] = { l.starts_offset, l.durations_offset, l.states_offset };
+        const uint64_t column_sizes[3] = { l.count * 8, l.count * 8, l.count * head.state_size };
+        for (int c = 0; c < 3; ++c) {
+            if ((columns[c] & 7) != 0 || columns[c] > size || column_sizes[c] > size - columns[c])
+                return fail("lane column outside of the file");
+        }
+    }
+    lane_versions.resize((int)head.lane_count);
+    for (uint64_t& version : lane_versions)
+        version = next_bar_stack_version();
+    return true;
+}
+
+void BarStackCaptureFile::close() {
+#ifdef _WIN32
+    if (data != nullptr)
+        UnmapViewOfFile(data);
+    if (mapping_handle != nullptr)
+        CloseHandle(mapping_handle);
+    if (file_handle != INVALID_HANDLE_VALUE)
+        CloseHandle(file_handle);
+    mapping_handle = nullptr;
+    file_handle = INVALID_HANDLE_VALUE;
+#else
+    if (data != nullptr)
+        munmap((void*)data, size);
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+#endif
+    data = nullptr;
+    size = 0;
+    lane_versions.clear();
+    last_error = nullptr;
+}
+
+const BarStackCaptureLane& BarStackCaptureFile::lane(int idx) const {
+    IM_ASSERT(is_open() && idx >= 0 && idx < lane_count());
+    return ((const BarStackCaptureLane*)(data + sizeof(BarStackCaptureHeader)))[idx];
+}
+
+template <typename T>
+BarStackTimelineView<T> BarStackCaptureFile::view(int idx) const {
+    BarStackTimelineView<T> result;
+    if (!is_open() || idx < 0 || idx >= lane_count() || state_size() != (int)sizeof(T))
+        return result;
+    const BarStackCaptureLane& l = lane(idx);
+    result.starts = (const uint64_t*)(data + l.starts_offset);
+    result.durations = (const uint64_t*)(data + l.durations_offset);
+    result.states = (const T*)(data + l.states_offset);
+    result.segments = (int)l.count;
+    result.origin = l.origin;
+    result.version = lane_versions[idx];
+    return result;
+}
+
+template <typename T>
+bool write_bar_stack_capture(const char* path, const BarStackTimeline<T>* const* lanes, const char* const* names, int lane_count) {
+    BarStackCaptureHeader head;
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, BAR_STACK_CAPTURE_MAGIC, sizeof(head.magic));
+    head.version = BAR_STACK_CAPTURE_VERSION;
+    head.lane_count = (uint32_t)lane_count;
+    head.state_size = sizeof(T);
+    // lay out the columns after the lane table
+    ImVector<BarStackCaptureLane> table;
+    table.resize(lane_count);
+    uint64_t offset = sizeof(BarStackCaptureHeader) + (uint64_t)lane_count * sizeof(BarStackCaptureLane);
+    for (int i = 0; i < lane_count; ++i) {
+        BarStackCaptureLane& l = table[i];
+        memset(&l, 0, sizeof(l));
+        if (names != nullptr && names[i] != nullptr)
+            ImStrncpy(l.name, names[i], IM_ARRAYSIZE(l.name));
+        l.count = (uint64_t)lanes[i]->count();
+        l.origin = lanes[i]->origin;
+        l.starts_offset = align_capture_offset(offset);
+        l.durations_offset = l.starts_offset + l.count * 8;
+        l.states_offset = l.durations_offset + l.count * 8;
+        offset = l.states_offset + l.count * sizeof(T);
+    }
+    head.file_size = align_capture_offset(offset);
+    FILE* f = fopen(path, "wb");
+    if (f == nullptr)
+        return false;
+    bool ok = fwrite(&head, sizeof(head), 1, f) == 1;
+    if (lane_count > 0)
+        ok = ok && fwrite(table.Data, sizeof(BarStackCaptureLane), lane_count, f) == (size_t)lane_count;
+    static const unsigned char padding[8] = {};
+    uint64_t written = sizeof(BarStackCaptureHeader) + (uint64_t)lane_count * sizeof(BarStackCaptureLane);
+    for (int i = 0; i < lane_count && ok; ++i) {
+        const BarStackTimeline<T>& timeline = *lanes[i];
+        const size_t count = (size_t)timeline.count();
+        const size_t pad = (size_t)(table[i].starts_offset - written);
+        ok = ok && (pad == 0 || fwrite(padding, 1, pad, f) == pad);
+        ok = ok && (count == 0 || fwrite(timeline.starts.Data, sizeof(uint64_t), count, f) == count);
+        ok = ok && (count == 0 || fwrite(timeline.durations.Data, sizeof(uint64_t), count, f) == count);
+        ok = ok && (count == 0 || fwrite(timeline.states.Data, sizeof(T), count, f) == count);
+        written = table[i].states_offset + count * sizeof(T);
+    }
+    const size_t pad = (size_t)(head.file_size - written);
+    ok = ok && (pad == 0 || fwrite(padding, 1, pad, f) == pad);
+    return fclose(f) == 0 && ok;
+}
+
+#define INSTANTIATE_MACRO(T) \
+    template BarStackTimelineView<T> BarStackCaptureFile::view<T>(int idx) const; \
+    template bool write_bar_stack_capture<T>(const char* path, const BarStackTimeline<T>* const* lanes, const char* const* names, int lane_count);
+CALL_INSTANTIATE_FOR_STATE_TYPES()
+#undef INSTANTIATE_MACRO
@@ -0,0 +1,75 @@
+#pragma once
+#include "plot_bar_stack_util.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Columnar capture file of state timelines, mapped read-only and plotted in place through BarStackTimelineView.
+// Layout, little endian, every column starts on an 8 byte boundary:
+//   BarStackCaptureHeader
+//   BarStackCaptureLane[lane_count]
+//   per lane: uint64_t starts[count]    prefix offsets, start time of each segment
+//             uint64_t durations[count]
+//             states[count], state_size bytes each
+// Only the header and the lane table are read when the file is opened, the columns are paged in by the plots that read them.
+
+static const char     BAR_STACK_CAPTURE_MAGIC[8] = { 'B', 'S', 'C', 'A', 'P', 'T', 'U', 'R' };
+static const uint32_t BAR_STACK_CAPTURE_VERSION  = 1;
+
+struct BarStackCaptureHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t lane_count;
+    uint32_t state_size; // bytes per state, shared by all lanes
+    uint32_t reserved;
+    uint64_t file_size;  // to detect truncated files
+};
+
+struct BarStackCaptureLane {
+    char     name[48];  // null terminated
+    uint64_t count;
+    uint64_t origin;
+    uint64_t starts_offset;
+    uint64_t durations_offset;
+    uint64_t states_offset;
+};
+
+// A capture file mapped into memory. The views it returns stay valid until close() or destruction.
+class BarStackCaptureFile {
+public:
+    BarStackCaptureFile();
+    ~BarStackCaptureFile();
+    BarStackCaptureFile(const BarStackCaptureFile&) = delete;
+    BarStackCaptureFile& operator=(const BarStackCaptureFile&) = delete;
+
+    // Maps path and validates its header and lane table, returns false and sets error() when the file can not be used
+    bool open(const char* path);
+    void close();
+    bool is_open() const { return data != nullptr; }
+    const char* error() const { return last_error; }
+
+    int lane_count() const { return is_open() ? (int)header().lane_count : 0; }
+    const BarStackCaptureLane& lane(int idx) const;
+    int state_size() const { return is_open() ? (int)header().state_size : 0; }
+    // Columns of a lane, T must have the state size of the file, else the view is empty. Its version stays the same until the file is reopened.
+    template <typename T> BarStackTimelineView<T> view(int idx) const;
+
+private:
+    const BarStackCaptureHeader& header() const { return *(const BarStackCaptureHeader*)data; }
+    bool fail(const char* message);
+
+    const unsigned char* data;
+    size_t               size;
+    ImVector<uint64_t>   lane_versions; // of the views of each lane, from next_bar_stack_version() when the file is opened
+    const char*          last_error;
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#else
+    int fd;
+#endif
+};
+
+// Writes timelines into a capture file at path, returns false on I/O errors. The open segment of push_transition() is written up to its latest sample.
+template <typename T>
+bool write_bar_stack_capture(const char* path, const BarStackTimeline<T>* const* lanes, const char* const* names, int lane_count);
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+// Memory layouts of an array read with ImPlot's offset/stride conventions.
+// ImPlot's IndexerIdx tests offset and stride on every element read, here the layout is picked once per call
+// and every loop over the data is compiled for it, so the contiguous case is a plain array walk.
+enum BarStackLayout {
+    BarStackLayout_Contiguous, // offset 0, stride sizeof(T)
+    BarStackLayout_Offset,     // circular buffer of packed elements, the oldest one at offset
+    BarStackLayout_Strided,    // interleaved records, offset 0
+    BarStackLayout_Ring,       // circular buffer of interleaved records
+};
+
+template <BarStackLayout L>
+using BarStackLayoutTag = std::integral_constant<BarStackLayout, L>;
+
+// Reads element idx in [0, count) of data, offset must already be wrapped into [0, count)
+template <BarStackLayout L, typename T>
+inline T bar_stack_load(const T* data, int idx, int count, int offset, int stride) {
+    if constexpr (L == BarStackLayout_Contiguous) {
+        return data[idx];
+    }
+    else if constexpr (L == BarStackLayout_Offset) {
+        const int wrapped = offset + idx;
+        return data[wrapped < count ? wrapped : wrapped - count];
+    }
+    else if constexpr (L == BarStackLayout_Strided) {
+        return *(const T*)(const void*)((const unsigned char*)data + (size_t)idx * stride);
+    }
+    else {
+        const int wrapped = offset + idx;
+        return *(const T*)(const void*)((const unsigned char*)data + (size_t)(wrapped < count ? wrapped : wrapped - count) * stride);
+    }
+}
+
+// Array of T read in its native type, the layout is a template argument
+template <typename T, BarStackLayout L = BarStackLayout_Contiguous>
+struct BarStackIndexer {
+    BarStackIndexer(const T* data, int count, int offset = 0, int stride = sizeof(T)) :
+        data(data),
+        count(count),
+        offset(count ? ((offset % count) + count) % count : 0),
+        stride(stride)
+    { }
+    T operator()(int idx) const { return bar_stack_load<L>(data, idx, count, offset, stride); }
+    const T* data;
+    int count;
+    int offset;
+    int stride;
+};
+
+// Picks the layout of an array of count elements of T and calls func(BarStackLayoutTag<L>()) with it
+template <typename T, typename Func>
+inline void with_bar_stack_layout(int count, int offset, int stride, Func&& func) {
+    const bool rotated = count != 0 && offset % count != 0;
+    const bool packed = stride == (int)sizeof(T);
+    if (!rotated && packed)
+        func(BarStackLayoutTag<BarStackLayout_Contiguous>());
+    else if (packed)
+        func(BarStackLayoutTag<BarStackLayout_Offset>());
+    else if (!rotated)
+        func(BarStackLayoutTag<BarStackLayout_Strided>());
+    else
+        func(BarStackLayoutTag<BarStackLayout_Ring>());
+}
@@ -0,0 +1,107 @@
+#include "bar_stack_ingest.h"
+#include "implot_internal.h"
+
+// The queue is the bounded MPMC queue described by Dmitry Vyukov: each cell carries a sequence number
+// telling whether it is free for the producer at position pos (sequence == pos)
+// or holds a transition for the consumer at position pos (sequence == pos + 1).
+
+template <typename T>
+BarStackIngestQueue<T>::BarStackIngestQueue(int capacity) :
+    enqueue_pos(0),
+    dequeue_pos(0),
+    pushed(0),
+    dropped(0),
+    full(0),
+    max_fill_seen(0)
+{
+    size_t size = 2;
+    while (size < (size_t)capacity)
+        size <<= 1;
+    cells = new Cell[size];
+    mask = size - 1;
+    for (size_t i = 0; i < size; ++i)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+BarStackIngestQueue<T>::~BarStackIngestQueue() {
+    delete[] cells;
+}
+
+template <typename T>
+bool BarStackIngestQueue<T>::push(uint64_t timestamp, T state) {
+    if (enqueue(timestamp, state))
+        return true;
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+template <typename T>
+bool BarStackIngestQueue<T>::try_push(uint64_t timestamp, T state) {
+    if (enqueue(timestamp, state))
+        return true;
+    full.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+// Returns false when the queue is full, the callers count the failure
+template <typename T>
+bool BarStackIngestQueue<T>::enqueue(uint64_t timestamp, T state) {
+    size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &cells[pos & mask];
+        const size_t seq = cell->sequence.load(std::memory_order_acquire);
+        const intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0) {
+            return false; // full
+        }
+        else {
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->transition.timestamp = timestamp;
+    cell->transition.state = state;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    pushed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename T>
+bool BarStackIngestQueue<T>::pop(BarStackTransition<T>* out) {
+    const size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+    Cell* cell = &cells[pos & mask];
+    const size_t seq = cell->sequence.load(std::memory_order_acquire);
+    if ((intptr_t)seq - (intptr_t)(pos + 1) < 0)
+        return false; // empty
+    *out = cell->transition;
+    cell->sequence.store(pos + mask + 1, std::memory_order_release);
+    dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename T>
+int BarStackIngestQueue<T>::drain(BarStackTimeline<T>& timeline, int max_count) {
+    const size_t queued = enqueue_pos.load(std::memory_order_relaxed) - dequeue_pos.load(std::memory_order_relaxed);
+    if ((int)queued > max_fill_seen.load(std::memory_order_relaxed))
+        max_fill_seen.store((int)queued, std::memory_order_relaxed);
+    // grow geometrically, reserving the exact size would reallocate the columns on almost every drain of a live stream
+    const int needed = timeline.count() + (int)ImMin(queued, (size_t)max_count);
+    if (needed > timeline.durations.Capacity)
+        timeline.reserve(ImMax(needed, timeline.durations.Capacity * 2));
+    int moved = 0;
+    BarStackTransition<T> transition;
+    while (moved < max_count && pop(&transition)) {
+        timeline.push_transition(transition.timestamp, transition.state);
+        moved++;
+    }
+    return moved;
+}
+
+#define INSTANTIATE_MACRO(T) template class BarStackIngestQueue<T>;
+CALL_INSTANTIATE_FOR_STATE_TYPES()
+#undef INSTANTIATE_MACRO
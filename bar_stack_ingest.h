@@ -0,0 +1,62 @@
+#pragma once
+#include "plot_bar_stack_util.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// A state change of one lane, as produced by an acquisition thread
+template <typename T>
+struct BarStackTransition {
+    uint64_t timestamp;
+    T        state;
+};
+
+// Bounded lock-free queue carrying transitions from acquisition threads to the UI thread.
+// Any number of threads may call push() or try_push(), a single thread (usually the UI thread) calls pop() or drain().
+// Producers never block: when the queue is full push() drops the event and counts it in dropped_count(),
+// a producer that wants back-pressure instead calls try_push() and retries later, its failed attempts are counted in full_count().
+template <typename T>
+class BarStackIngestQueue {
+public:
+    // capacity is rounded up to a power of two
+    explicit BarStackIngestQueue(int capacity);
+    ~BarStackIngestQueue();
+    BarStackIngestQueue(const BarStackIngestQueue&) = delete;
+    BarStackIngestQueue& operator=(const BarStackIngestQueue&) = delete;
+
+    // Producer side, safe to call from any thread. Returns false when the queue is full and the transition was dropped.
+    bool push(uint64_t timestamp, T state);
+    // Same as push(), but a full queue is back-pressure: the producer keeps the transition and retries, nothing is dropped
+    bool try_push(uint64_t timestamp, T state);
+    // Consumer side, must only be called from one thread at a time
+    bool pop(BarStackTransition<T>* out);
+    // Moves at most max_count queued transitions into timeline, returns the number of transitions moved
+    int drain(BarStackTimeline<T>& timeline, int max_count = INT32_MAX);
+
+    int capacity() const { return (int)(mask + 1); }
+    uint64_t pushed_count() const { return pushed.load(std::memory_order_relaxed); }
+    // Transitions lost by push() on a full queue
+    uint64_t dropped_count() const { return dropped.load(std::memory_order_relaxed); }
+    // Calls of try_push() that found the queue full, a transition retried several times is counted each time
+    uint64_t full_count() const { return full.load(std::memory_order_relaxed); }
+    // Largest number of queued transitions seen by drain()
+    int max_fill() const { return max_fill_seen.load(std::memory_order_relaxed); }
+
+private:
+    bool enqueue(uint64_t timestamp, T state);
+
+    struct Cell {
+        std::atomic<size_t>   sequence;
+        BarStackTransition<T> transition;
+    };
+    // keep the producer and the consumer positions on separate cache lines
+    alignas(64) std::atomic<size_t> enqueue_pos;
+    alignas(64) std::atomic<size_t> dequeue_pos;
+    alignas(64) std::atomic<uint64_t> pushed;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> full;
+    std::atomic<int>      max_fill_seen;
+    Cell*  cells;
+    size_t mask;
+};
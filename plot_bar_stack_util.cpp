@@ -1,36 +1,106 @@
 #include "plot_bar_stack_util.h"
 #include "implot_internal.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// SSE2 is part of x86-64, 32-bit x86 builds only get the SIMD kernels when they are compiled for SSE2 (-msse2, /arch:SSE2)
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BAR_STACK_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
 namespace
 {
-    // Helper function to get color base on value
-    template<typename T>
-    ImU32 get_color_based_on_value(T value) {
-        ImColor color; // Declare an ImColor variable
-
-        // Check if the type is bool
-        if constexpr (std::is_same<T, bool>::value) {
-            color = value ? ImColor(0, 0, 255, 255) : ImColor(255, 0, 0, 255); // Blue for true, Red for false
-        }
-        // Check if the type is int
-        else if constexpr (std::is_same<T, int>::value) {
-            if (value > 0) {
-                color = ImColor(128, 0, 128, 255); // Purple for int > 0
-            }
-            else if (value < 0) {
-                color = ImColor(255, 255, 0, 255); // Yellow for int < 0
-            }
-            else {
-                color = ImColor(0, 0, 0, 255); // Black for int == 0, as an edge case
-            }
+    // Index of a state in a palette, negative states wrap around to indices past the end of any palette
+    template <typename T>
+    uint64_t state_index(T value) {
+        if constexpr (std::is_enum<T>::value)
+            return (uint64_t)(typename std::underlying_type<T>::type)value;
+        else
+            return (uint64_t)value;
+    }
+
+    // Color of state code idx past ImPlotColormap_Deep: hues stepped by the golden ratio, so any run of codes gets well spread hues,
+    // at the saturation and value of the Deep colors
+    constexpr ImU32 golden_ratio_color(uint64_t idx) {
+        const uint32_t hue = (uint32_t)((idx * 0x9E3779B97F4A7C15ull) >> 48) * 6; // sector in the high 16 bits, position in it in the low ones
+        const uint32_t v = 210, lo = 90;
+        const uint32_t rise = lo + ((v - lo) * (hue & 0xFFFF) >> 16);
+        const uint32_t fall = v - ((v - lo) * (hue & 0xFFFF) >> 16);
+        switch (hue >> 16) {
+            case 0:  return IM_COL32(v, rise, lo, 255);
+            case 1:  return IM_COL32(fall, v, lo, 255);
+            case 2:  return IM_COL32(lo, v, rise, 255);
+            case 3:  return IM_COL32(lo, fall, v, 255);
+            case 4:  return IM_COL32(rise, lo, v, 255);
+            default: return IM_COL32(v, lo, fall, 255);
         }
-        // Default case for unsupported types
-        else {
-            color = ImColor(255, 255, 255, 255); // White for unsupported types
+    }
+
+    // Colors of ImPlotColormap_Deep for categorical state codes, further states get golden_ratio_color()
+    struct PaletteDeep {
+        template <typename T> ImU32 operator()(T value) const {
+            static const ImU32 colors[10] = {
+                IM_COL32(0x4C, 0x72, 0xB0, 255), IM_COL32(0xDD, 0x84, 0x52, 255), IM_COL32(0x55, 0xA8, 0x68, 255), IM_COL32(0xC4, 0x4E, 0x52, 255),
+                IM_COL32(0x81, 0x72, 0xB3, 255), IM_COL32(0x93, 0x78, 0x60, 255), IM_COL32(0xDA, 0x8B, 0xC3, 255), IM_COL32(0x8C, 0x8C, 0x8C, 255),
+                IM_COL32(0xCC, 0xB9, 0x74, 255), IM_COL32(0x64, 0xB5, 0xCD, 255)
+            };
+            const uint64_t idx = state_index(value);
+            return idx < 10 ? colors[idx] : golden_ratio_color(idx);
         }
+    };
 
-        return color; // Implicitly converts ImColor to ImU32
-    }
+    // Colors of signed integer states by their sign
+    struct PaletteSign {
+        template <typename T> ImU32 operator()(T value) const {
+            static const ImU32 colors[3] = {
+                IM_COL32(255, 255, 0, 255), // Yellow for value < 0
+                IM_COL32(0, 0, 0, 255),     // Black for value == 0, as an edge case
+                IM_COL32(128, 0, 128, 255)  // Purple for value > 0
+            };
+            return colors[(value > 0) - (value < 0) + 1];
+        }
+    };
+
+    // Default state colors, chosen at compile time from the state type. Signed integers of any width use PaletteSign, unsigned
+    // integer state codes use PaletteDeep. Enums are plotted with BarStackFlags_Categorical, which always picks PaletteDeep.
+    template <typename T, typename Enable = void>
+    struct PaletteDefault : PaletteDeep { };
+
+    template <typename T>
+    struct PaletteDefault<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type> : PaletteSign { };
+
+    template <>
+    struct PaletteDefault<bool> {
+        ImU32 operator()(bool value) const {
+            static const ImU32 colors[2] = {
+                IM_COL32(255, 0, 0, 255), // Red for false
+                IM_COL32(0, 0, 255, 255)  // Blue for true
+            };
+            return colors[value ? 1 : 0];
+        }
+    };
+
+    // Dense lookup table from set_next_bar_stack_palette() or BarStackTimeline::set_palette()
+    struct PaletteLut {
+        PaletteLut(const BarStackPalette& palette) : colors(palette.colors), count((uint64_t)palette.count), fallback(palette.fallback) { }
+        template <typename T> ImU32 operator()(T value) const {
+            const uint64_t idx = state_index(value);
+            return idx < count ? colors[idx] : fallback;
+        }
+        const ImU32* colors;
+        const uint64_t count;
+        const ImU32 fallback;
+    };
 }
 
 // This section is copied from Utils in implot_items.cpp
@@ -43,39 +113,30 @@ struct MaxIdx { static const unsigned int value; };
 template <> const unsigned int MaxIdx<unsigned short>::value = 65535;
 template <> const unsigned int MaxIdx<unsigned int>::value = 4294967295;
 
+// Versions of all stack data are drawn from one counter, so data rebuilt at the address of older data, like a stack-local
+// timeline, never repeats an (address, version) pair a cache has seen. A version raised by hand is skipped past.
+static std::atomic<uint64_t> version_counter(0);
+
+static uint64_t next_version(uint64_t version) {
+    uint64_t counter = version_counter.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        next = ImMax(counter, version) + 1;
+    } while (!version_counter.compare_exchange_weak(counter, next, std::memory_order_relaxed));
+    return next;
+}
+
+uint64_t next_bar_stack_version(uint64_t version) {
+    return next_version(version);
+}
+
 
 // This section is copied from Indexers section in implot_items.cpp
 //-----------------------------------------------------------------------------
 // [SECTION] Indexers
 //-----------------------------------------------------------------------------
-template <typename T>
-T index_data(const T* data, int idx, int count, int offset, int stride) {
-    const int s = ((offset == 0) << 0) | ((stride == sizeof(T)) << 1);
-    switch (s) {
-    case 3: return data[idx];
-    case 2: return data[(offset + idx) % count];
-    case 1: return *(const T*)(const void*)((const unsigned char*)data + (size_t)((idx)) * stride);
-    case 0: return *(const T*)(const void*)((const unsigned char*)data + (size_t)((offset + idx) % count) * stride);
-    default: return T(0);
-    }
-}
-
-template <typename T>
-struct IndexerIdx {
-    IndexerIdx(const T* data, int count, int offset = 0, int stride = sizeof(T)) :
-        data(data),
-        count(count),
-        offset(count ? ImPosMod(offset, count) : 0),
-        stride(stride)
-    { }
-    template <typename I>double operator()(I idx) const {
-        return (double)index_data(data, idx, count, offset, stride);
-    }
-    const T* data;
-    int count;
-    int offset;
-    int stride;
-};
+// Raw arrays are read with BarStackIndexer from bar_stack_indexers.h, which takes the place of IndexerIdx
+// and resolves offset and stride at compile time
 
 template <typename _Indexer1, typename _Indexer2>
 struct IndexerAdd {
@@ -105,6 +166,29 @@ struct IndexerLin {
     const double b;
 };
 
+// Reads the segment extents of a BarStackIndex or a BarStackTimeline, starting at segment first
+template <typename _Index>
+struct IndexerStackMin {
+    IndexerStackMin(const _Index& index, int first, int count) : index(index), first(first), count(count) { }
+    template <typename I> double operator()(I idx) const {
+        return index.segment_min(first + (int)idx);
+    }
+    const _Index& index;
+    const int first;
+    const int count;
+};
+
+template <typename _Index>
+struct IndexerStackMax {
+    IndexerStackMax(const _Index& index, int first, int count) : index(index), first(first), count(count) { }
+    template <typename I> double operator()(I idx) const {
+        return index.segment_max(first + (int)idx);
+    }
+    const _Index& index;
+    const int first;
+    const int count;
+};
+
 struct IndexerConst {
     IndexerConst(double ref) : ref(ref) { }
     template <typename I>double operator()(I) const { return ref; }
@@ -126,6 +210,43 @@ struct GetterXY {
     const int count;
 };
 
+//-----------------------------------------------------------------------------
+// [SECTION] Colorers
+//-----------------------------------------------------------------------------
+// Colorers map a segment index to its fill color, so one renderer pass can draw segments of different colors
+
+template <typename T, typename _Palette, typename _Values = std::vector<T>>
+struct ColorerValue {
+    ColorerValue(const _Values& values, const _Palette& palette) : values(values), palette(palette) { }
+    template <typename I> ImU32 operator()(I idx) const {
+        return palette((T)values[idx]);
+    }
+    const _Values& values;
+    const _Palette& palette;
+};
+
+template <typename T, typename _Palette, BarStackLayout L = BarStackLayout_Contiguous>
+struct ColorerData {
+    ColorerData(const T* data, int count, int offset, int stride, const _Palette& palette) :
+        indexer(data, count, offset, stride),
+        palette(palette)
+    { }
+    template <typename I> ImU32 operator()(I idx) const {
+        return palette(indexer((int)idx));
+    }
+    const BarStackIndexer<T, L> indexer;
+    const _Palette& palette;
+};
+
+// Resolves the colors of segments [first, first + count) in one tight loop, the renderer then reads them as an array
+template <typename _Colorer>
+void resolve_colors(const _Colorer& colorer, int first, int count, ImVector<ImU32>& out) {
+    out.resize(count);
+    ImU32* colors = out.Data;
+    for (int i = 0; i < count; ++i)
+        colors[i] = colorer(first + i);
+}
+
 // This section is copied from Fitters in implot_items.cpp
 //-----------------------------------------------------------------------------
 // [SECTION] Fitters
@@ -154,6 +275,36 @@ struct FitterBarH {
     const double    half_height;
 };
 
+// Same result as FitterBarH over a whole stack, in O(1): segments are contiguous, so the stack covers
+// [stack_min, stack_max] along X and every segment shares the lane's Y span.
+template <typename _Index>
+struct FitterBarStackH {
+    FitterBarStackH(const _Index& index, int count, double shift, double height) :
+        index(index),
+        count(count),
+        shift(shift),
+        half_height(height * 0.5)
+    { }
+    void Fit(ImPlotAxis& x_axis, ImPlotAxis& y_axis) const {
+        if (count <= 0)
+            return;
+        const double x_min = index.stack_min(count);
+        const double x_max = index.stack_max(count);
+        const double y_min = shift - half_height;
+        const double y_max = shift + half_height;
+        x_axis.ExtendFitWith(y_axis, x_min, y_min);
+        x_axis.ExtendFitWith(y_axis, x_max, y_max);
+        // for ImPlotAxisFlags_RangeFit, the lane counts as visible if any part of it lies in the X range
+        const double x_alt = ImClamp(x_axis.Range.Min, x_min, x_max);
+        y_axis.ExtendFitWith(x_axis, y_min, x_alt);
+        y_axis.ExtendFitWith(x_axis, y_max, x_alt);
+    }
+    const _Index& index;
+    const int     count;
+    const double  shift;
+    const double  half_height;
+};
+
 // This section is copied from Item Utils in implot_items.cpp
 //-----------------------------------------------------------------------------
 // [SECTION] Item Utils
@@ -190,6 +341,138 @@ void prim_rect_fill(ImDrawList& draw_list, const ImVec2& Pmin, const ImVec2& Pma
     draw_list._VtxCurrentIdx += 4;
 }
 
+// Same quad as prim_rect_fill, written at explicit positions without touching the draw list cursors
+void prim_rect_write(ImDrawVert* vtx, ImDrawIdx* idx, unsigned int vtx_idx, const ImVec2& Pmin, const ImVec2& Pmax, ImU32 col, const ImVec2& uv) {
+    vtx[0].pos = Pmin;
+    vtx[0].uv = uv;
+    vtx[0].col = col;
+    vtx[1].pos = Pmax;
+    vtx[1].uv = uv;
+    vtx[1].col = col;
+    vtx[2].pos.x = Pmin.x;
+    vtx[2].pos.y = Pmax.y;
+    vtx[2].uv = uv;
+    vtx[2].col = col;
+    vtx[3].pos.x = Pmax.x;
+    vtx[3].pos.y = Pmin.y;
+    vtx[3].uv = uv;
+    vtx[3].col = col;
+    idx[0] = (ImDrawIdx)(vtx_idx);
+    idx[1] = (ImDrawIdx)(vtx_idx + 1);
+    idx[2] = (ImDrawIdx)(vtx_idx + 2);
+    idx[3] = (ImDrawIdx)(vtx_idx);
+    idx[4] = (ImDrawIdx)(vtx_idx + 1);
+    idx[5] = (ImDrawIdx)(vtx_idx + 3);
+}
+
+static const int ITEM_ENTRY_IDLE_FRAMES = 600; // frames an entry may go unused before it is freed, with the item it belongs to
+
+// Entries of one type, allocated one by one like the windows of ImGuiContext: an ImVector<Entry> would move them with
+// memcpy when it grows and never run their destructors, and a reference to an entry stays valid when another is added.
+// Entries of items no longer plotted are freed once they went unused for
+// ITEM_ENTRY_IDLE_FRAMES, an entry used in the current frame is never freed.
+template <typename Entry>
+struct ItemEntries {
+    ItemEntries() : sweep_frame(0) { }
+    ~ItemEntries() {
+        for (Entry* entry : entries)
+            IM_DELETE(entry);
+    }
+    // Frees the entries unused for ITEM_ENTRY_IDLE_FRAMES, runs once per ITEM_ENTRY_IDLE_FRAMES
+    void sweep(int frame) {
+        sweep_frame = frame;
+        int n = 0;
+        for (int i = 0; i < entries.Size; ++i) {
+            if (frame - last_used[i] > ITEM_ENTRY_IDLE_FRAMES) {
+                IM_DELETE(entries[i]);
+                index_by_id.SetInt(ids[i], -1);
+                continue;
+            }
+            if (n != i) {
+                entries[n] = entries[i];
+                ids[n] = ids[i];
+                last_used[n] = last_used[i];
+                index_by_id.SetInt(ids[n], n);
+            }
+            ++n;
+        }
+        if (n == entries.Size)
+            return;
+        entries.resize(n);
+        ids.resize(n);
+        last_used.resize(n);
+        // drop the pairs of the freed entries, the others stay sorted by key
+        int pairs = 0;
+        for (int i = 0; i < index_by_id.Data.Size; ++i) {
+            if (index_by_id.Data[i].val_i >= 0)
+                index_by_id.Data[pairs++] = index_by_id.Data[i];
+        }
+        index_by_id.Data.resize(pairs);
+    }
+    ImVector<Entry*>  entries;
+    ImVector<ImGuiID> ids;         // of each entry
+    ImVector<int>     last_used;   // frame each entry was last returned in
+    ImGuiStorage      index_by_id; // index into entries
+    int               sweep_frame;
+};
+
+// State of type Entry kept across frames for the item (or any other id), default constructed on first use
+template <typename Entry>
+Entry& get_item_entry(ImGuiID id) {
+    static ItemEntries<Entry> storage;
+    const int frame = ImGui::GetFrameCount();
+    if (frame - storage.sweep_frame > ITEM_ENTRY_IDLE_FRAMES)
+        storage.sweep(frame);
+    int idx = storage.index_by_id.GetInt(id, -1);
+    if (idx < 0) {
+        idx = storage.entries.Size;
+        storage.entries.push_back(IM_NEW(Entry)());
+        storage.ids.push_back(id);
+        storage.last_used.push_back(frame);
+        storage.index_by_id.SetInt(id, idx);
+    }
+    storage.last_used[idx] = frame;
+    return *storage.entries[idx];
+}
+
+// Everything the cached output of a stack depends on, kept whole in the cache entries and compared bytewise, so two
+// different keys never match. The members are ordered by alignment, there is no padding on 32 or 64 bit targets.
+// The colors of a palette are not compared, a palette changed in place is only picked up with the next data change.
+struct StackKey {
+    StackKey() { memset((void*)this, 0, sizeof(*this)); }
+    bool operator==(const StackKey& other) const { return memcmp(this, &other, sizeof(*this)) == 0; }
+    bool operator!=(const StackKey& other) const { return !(*this == other); }
+    // Every input of Transformer1: an inverted axis keeps its range but swaps its pixel ends, a log axis only differs by its transform
+    struct Axis {
+        void set(const ImPlotAxis& axis) {
+            min = axis.Range.Min;
+            max = axis.Range.Max;
+            pixel_min = axis.PixelMin;
+            scale = axis.ScaleToPixel;
+            scale_min = axis.ScaleMin;
+            scale_max = axis.ScaleMax;
+            transform = axis.TransformForward;
+            transform_data = axis.TransformData;
+        }
+        double          min, max;
+        double          pixel_min;
+        double          scale;
+        double          scale_min, scale_max;
+        ImPlotTransform transform;
+        void*           transform_data;
+    };
+    uint64_t        version;
+    Axis            x;
+    Axis            y;
+    double          height, shift;
+    ImRect          plot_rect;
+    ImVec2          uv;
+    BarStackPalette palette;
+    const void*     data;
+    int             count;
+    int             flags;
+};
+
 // This section is copied from BeginItem / EndItem in implot_items.cpp
 //-----------------------------------------------------------------------------
 // [SECTION] BeginItem / EndItem
@@ -222,6 +505,17 @@ struct Transformer1 {
         transform_data(data)
     { }
 
+    Transformer1(const ImPlotAxis& axis) :
+        Transformer1(axis.PixelMin,
+            axis.Range.Min,
+            axis.Range.Max,
+            axis.ScaleToPixel,
+            axis.ScaleMin,
+            axis.ScaleMax,
+            axis.TransformForward,
+            axis.TransformData)
+    { }
+
     template <typename T> float operator()(T p) const {
         if (transform_fwd != nullptr) {
             double s = transform_fwd(p, transform_data);
@@ -282,6 +576,83 @@ struct Transformer2 {
     Transformer1 t_y;
 };
 
+//-----------------------------------------------------------------------------
+// [SECTION] Batch Transformers
+//-----------------------------------------------------------------------------
+// For linear axes Transformer1 is an affine map, so whole arrays of coordinates are converted with SIMD kernels.
+// Every kernel evaluates the same expression as Transformer1 in double precision, the results are identical.
+
+typedef void (*TransformKernel)(const double* in, float* out, int count, double plt_min, double m, double pix_min);
+
+static void transform_linear_scalar(const double* in, float* out, int count, double plt_min, double m, double pix_min) {
+    for (int i = 0; i < count; ++i)
+        out[i] = (float)(pix_min + m * (in[i] - plt_min));
+}
+
+#ifdef BAR_STACK_SIMD_X86
+static void transform_linear_sse2(const double* in, float* out, int count, double plt_min, double m, double pix_min) {
+    const __m128d v_plt_min = _mm_set1_pd(plt_min);
+    const __m128d v_m = _mm_set1_pd(m);
+    const __m128d v_pix_min = _mm_set1_pd(pix_min);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128d a = _mm_add_pd(v_pix_min, _mm_mul_pd(v_m, _mm_sub_pd(_mm_loadu_pd(in + i), v_plt_min)));
+        const __m128d b = _mm_add_pd(v_pix_min, _mm_mul_pd(v_m, _mm_sub_pd(_mm_loadu_pd(in + i + 2), v_plt_min)));
+        _mm_storeu_ps(out + i, _mm_movelh_ps(_mm_cvtpd_ps(a), _mm_cvtpd_ps(b)));
+    }
+    transform_linear_scalar(in + i, out + i, count - i, plt_min, m, pix_min);
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx")))
+#endif
+static void transform_linear_avx(const double* in, float* out, int count, double plt_min, double m, double pix_min) {
+    const __m256d v_plt_min = _mm256_set1_pd(plt_min);
+    const __m256d v_m = _mm256_set1_pd(m);
+    const __m256d v_pix_min = _mm256_set1_pd(pix_min);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256d a = _mm256_add_pd(v_pix_min, _mm256_mul_pd(v_m, _mm256_sub_pd(_mm256_loadu_pd(in + i), v_plt_min)));
+        const __m256d b = _mm256_add_pd(v_pix_min, _mm256_mul_pd(v_m, _mm256_sub_pd(_mm256_loadu_pd(in + i + 4), v_plt_min)));
+        _mm_storeu_ps(out + i, _mm256_cvtpd_ps(a));
+        _mm_storeu_ps(out + i + 4, _mm256_cvtpd_ps(b));
+    }
+    transform_linear_scalar(in + i, out + i, count - i, plt_min, m, pix_min);
+}
+
+static bool cpu_has_avx() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    // the OS must also save the YMM registers on context switches
+    return avx && osxsave && (_xgetbv(0) & 6) == 6;
+#else
+    return __builtin_cpu_supports("avx");
+#endif
+}
+#endif
+
+static TransformKernel select_transform_kernel() {
+#ifdef BAR_STACK_SIMD_X86
+    return cpu_has_avx() ? transform_linear_avx : transform_linear_sse2;
+#else
+    return transform_linear_scalar;
+#endif
+}
+
+// Converts count plot coordinates to pixels, only non-linear axes take the per-point path
+void transform_batch(const Transformer1& t, const double* in, float* out, int count) {
+    static const TransformKernel transform_linear = select_transform_kernel();
+    if (t.transform_fwd != nullptr) {
+        for (int i = 0; i < count; ++i)
+            out[i] = t(in[i]);
+        return;
+    }
+    transform_linear(in, out, count, t.plt_min, t.m, t.pix_min);
+}
+
 // This section is copied from Renderers in implot_items.cpp
 //-----------------------------------------------------------------------------
 // [SECTION] Renderers
@@ -337,6 +708,200 @@ struct RendererBarsFillH : RendererBase {
     mutable ImVec2 uv;
 };
 
+// Same as RendererBarsFillH, but renders whole stacks in one pass from X extents already converted to pixels by transform_batch.
+// Each bar reads its own color. The vertical pixel spans are read with y_stride, 0 when all bars share the span of one lane.
+struct RendererBarStackPixH : RendererBase {
+    RendererBarStackPixH(const float* px_min, const float* px_max, const ImU32* colors, int count, const float* y_min, const float* y_max, int y_stride) :
+        RendererBase(count, 6, 4),
+        px_min(px_min),
+        px_max(px_max),
+        colors(colors),
+        y_min(y_min),
+        y_max(y_max),
+        y_stride(y_stride)
+    {}
+    void Init(ImDrawList& draw_list) const {
+        uv = draw_list._Data->TexUvWhitePixel;
+    }
+    bool Render(ImDrawList& draw_list, const ImRect& cull_rect, int prim) const {
+        if (!Visible(cull_rect, prim))
+            return false;
+        prim_rect_fill(draw_list, PMin(prim), PMax(prim), colors[prim], uv);
+        return true;
+    }
+    // Split form of Render used by RenderPrimitivesParallel
+    bool Visible(const ImRect& cull_rect, int prim) const {
+        return cull_rect.Overlaps(ImRect(PMin(prim), PMax(prim)));
+    }
+    void Write(ImDrawVert* vtx, ImDrawIdx* idx, unsigned int vtx_idx, int prim) const {
+        prim_rect_write(vtx, idx, vtx_idx, PMin(prim), PMax(prim), colors[prim], uv);
+    }
+    ImVec2 PMin(int prim) const { return ImVec2(px_min[prim], y_min[prim * y_stride]); }
+    ImVec2 PMax(int prim) const { return ImVec2(px_max[prim], y_max[prim * y_stride]); }
+    const float* px_min;
+    const float* px_max;
+    const ImU32* colors;
+    const float* y_min;
+    const float* y_max;
+    const int y_stride;
+    mutable ImVec2 uv;
+};
+
+// A glyph quad of a label, laid out in pixels
+struct LabelGlyph {
+    ImVec2             p_min;
+    ImVec2             p_max;
+    const ImFontGlyph* glyph;
+};
+
+// Renders the glyphs of many labels in one pass, like ImFont::RenderText does for a single string
+struct RendererLabelGlyphs : RendererBase {
+    RendererLabelGlyphs(const LabelGlyph* glyphs, int count, ImU32 col) :
+        RendererBase(count, 6, 4),
+        glyphs(glyphs),
+        col(col)
+    {}
+    void Init(ImDrawList&) const { }
+    bool Render(ImDrawList& draw_list, const ImRect& cull_rect, int prim) const {
+        const LabelGlyph& g = glyphs[prim];
+        if (!cull_rect.Overlaps(ImRect(g.p_min, g.p_max)))
+            return false;
+        draw_list.PrimRectUV(g.p_min, g.p_max, ImVec2(g.glyph->U0, g.glyph->V0), ImVec2(g.glyph->U1, g.glyph->V1), col);
+        return true;
+    }
+    const LabelGlyph* glyphs;
+    const ImU32 col;
+};
+
+//-----------------------------------------------------------------------------
+// [SECTION] Stats
+//-----------------------------------------------------------------------------
+
+static ImVector<BarStackStats> frame_stats;
+static int                     frame_stats_frame = -1;
+static int                     active_stats_index = -1; // entry of frame_stats of the plot_bar_stack call in progress
+
+// Counters of the plot_bar_stack call in progress, or nullptr. Only valid until the next call pushes its entry,
+// frame_stats may then be reallocated.
+static BarStackStats* active_stats() {
+    return active_stats_index >= 0 ? &frame_stats[active_stats_index] : nullptr;
+}
+
+// Records the counters of one plot_bar_stack call, from construction to destruction.
+// Scopes may nest, the counters then go to the inner call until it returns.
+struct StatsScope {
+    StatsScope(const char* label_id, int segments) : start(std::chrono::steady_clock::now()), outer_index(active_stats_index) {
+        if (frame_stats_frame != ImGui::GetFrameCount()) {
+            frame_stats.resize(0);
+            frame_stats_frame = ImGui::GetFrameCount();
+        }
+        frame_stats.push_back(BarStackStats());
+        active_stats_index = frame_stats.Size - 1;
+        BarStackStats& stats = frame_stats.back();
+        ImStrncpy(stats.label, label_id, IM_ARRAYSIZE(stats.label));
+        stats.segments = segments;
+        stats.segments_hidden = segments; // until the visible segments are known
+    }
+    ~StatsScope() {
+        active_stats()->elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        active_stats_index = outer_index;
+    }
+    const std::chrono::steady_clock::time_point start;
+    const int outer_index;
+};
+
+static void stats_visible(int segments) {
+    if (BarStackStats* stats = active_stats())
+        stats->segments_hidden -= segments;
+}
+
+static void stats_scanned(int segments) {
+    if (BarStackStats* stats = active_stats())
+        stats->segments_scanned += segments;
+}
+
+static void stats_replay(int vtx_count) {
+    if (BarStackStats* stats = active_stats())
+        stats->vtx_replayed += vtx_count;
+}
+
+static void stats_render(unsigned int prims, unsigned int prims_culled) {
+    if (BarStackStats* stats = active_stats()) {
+        stats->prims += prims;
+        stats->prims_culled += prims_culled;
+    }
+}
+
+// PrimReserve and PrimUnreserve of the renderers, counted in the active stats
+static void prim_reserve(ImDrawList& draw_list, int idx_count, int vtx_count) {
+    const int cmd_count = draw_list.CmdBuffer.Size;
+    draw_list.PrimReserve(idx_count, vtx_count);
+    if (BarStackStats* stats = active_stats()) {
+        stats->idx_reserved += idx_count;
+        stats->vtx_reserved += vtx_count;
+        stats->draw_cmd_splits += draw_list.CmdBuffer.Size - cmd_count;
+    }
+}
+
+static void prim_unreserve(ImDrawList& draw_list, int idx_count, int vtx_count) {
+    draw_list.PrimUnreserve(idx_count, vtx_count);
+    if (BarStackStats* stats = active_stats()) {
+        stats->idx_unreserved += idx_count;
+        stats->vtx_unreserved += vtx_count;
+    }
+}
+
+const ImVector<BarStackStats>& get_bar_stack_stats() {
+    return frame_stats;
+}
+
+void show_bar_stack_stats_window(bool* p_open, int max_rows) {
+    if (!ImGui::Begin("Bar Stack Stats", p_open)) {
+        ImGui::End();
+        return;
+    }
+    static ImVector<int> order;
+    order.resize(frame_stats.Size);
+    double total_ms = 0;
+    for (int i = 0; i < frame_stats.Size; ++i) {
+        order[i] = i;
+        total_ms += frame_stats[i].elapsed_ms;
+    }
+    std::sort(order.begin(), order.end(), [](int a, int b) { return frame_stats[a].elapsed_ms > frame_stats[b].elapsed_ms; });
+    ImGui::Text("%d stacks, %.3f ms", frame_stats.Size, total_ms);
+    if (ImGui::BeginTable("##BarStackStats", 11, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Stack");
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableSetupColumn("Segments");
+        ImGui::TableSetupColumn("Hidden");
+        ImGui::TableSetupColumn("Scanned");
+        ImGui::TableSetupColumn("Prims");
+        ImGui::TableSetupColumn("Culled");
+        ImGui::TableSetupColumn("Vtx/Idx reserved");
+        ImGui::TableSetupColumn("Vtx/Idx unreserved");
+        ImGui::TableSetupColumn("Splits");
+        ImGui::TableSetupColumn("Replayed");
+        ImGui::TableHeadersRow();
+        for (int r = 0; r < ImMin(max_rows, order.Size); ++r) {
+            const BarStackStats& stats = frame_stats[order[r]];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(stats.label);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", stats.elapsed_ms);
+            ImGui::TableNextColumn(); ImGui::Text("%d", stats.segments);
+            ImGui::TableNextColumn(); ImGui::Text("%d", stats.segments_hidden);
+            ImGui::TableNextColumn(); ImGui::Text("%d", stats.segments_scanned);
+            ImGui::TableNextColumn(); ImGui::Text("%d", stats.prims);
+            ImGui::TableNextColumn(); ImGui::Text("%d", stats.prims_culled);
+            ImGui::TableNextColumn(); ImGui::Text("%d/%d", stats.vtx_reserved, stats.idx_reserved);
+            ImGui::TableNextColumn(); ImGui::Text("%d/%d", stats.vtx_unreserved, stats.idx_unreserved);
+            ImGui::TableNextColumn(); ImGui::Text("%d", stats.draw_cmd_splits);
+            ImGui::TableNextColumn(); ImGui::Text("%d", stats.vtx_replayed);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
 // This section is copied from RenderPrimitives in implot_items.cpp
 //-----------------------------------------------------------------------------
 // [SECTION] RenderPrimitives
@@ -345,6 +910,7 @@ template <class _Renderer>
 void RenderPrimitivesEx(const _Renderer& renderer, ImDrawList& draw_list, const ImRect& cull_rect) {
     unsigned int prims = renderer.prims;
     unsigned int prims_culled = 0;
+    unsigned int culled_total = 0;
     unsigned int idx = 0;
     renderer.Init(draw_list);
     while (prims) {
@@ -356,28 +922,31 @@ void RenderPrimitivesEx(const _Renderer& renderer, ImDrawList& draw_list, const
                 prims_culled -= cnt; // reuse previous reservation
             else {
                 // add more elements to previous reservation
-                draw_list.PrimReserve((cnt - prims_culled) * renderer.idx_consumed, (cnt - prims_culled) * renderer.vtx_consumed);
+                prim_reserve(draw_list, (cnt - prims_culled) * renderer.idx_consumed, (cnt - prims_culled) * renderer.vtx_consumed);
                 prims_culled = 0;
             }
         }
         else
         {
             if (prims_culled > 0) {
-                draw_list.PrimUnreserve(prims_culled * renderer.idx_consumed, prims_culled * renderer.vtx_consumed);
+                prim_unreserve(draw_list, prims_culled * renderer.idx_consumed, prims_culled * renderer.vtx_consumed);
                 prims_culled = 0;
             }
             cnt = ImMin(prims, (MaxIdx<ImDrawIdx>::value - 0/*draw_list._VtxCurrentIdx*/) / renderer.vtx_consumed);
             // reserve new draw command
-            draw_list.PrimReserve(cnt * renderer.idx_consumed, cnt * renderer.vtx_consumed);
+            prim_reserve(draw_list, cnt * renderer.idx_consumed, cnt * renderer.vtx_consumed);
         }
         prims -= cnt;
         for (unsigned int ie = idx + cnt; idx != ie; ++idx) {
-            if (!renderer.Render(draw_list, cull_rect, idx))
+            if (!renderer.Render(draw_list, cull_rect, idx)) {
                 prims_culled++;
+                culled_total++;
+            }
         }
     }
     if (prims_culled > 0)
-        draw_list.PrimUnreserve(prims_culled * renderer.idx_consumed, prims_culled * renderer.vtx_consumed);
+        prim_unreserve(draw_list, prims_culled * renderer.idx_consumed, prims_culled * renderer.vtx_consumed);
+    stats_render(renderer.prims, culled_total);
 }
 
 template <template <class, class> class _Renderer, class _Getter1, class _Getter2, typename ...Args>
@@ -388,63 +957,2591 @@ void RenderPrimitives2(const _Getter1& getter1, const _Getter2& getter2, Args...
 }
 
 //-----------------------------------------------------------------------------
-// [SECTION] New function for Ploting continous bar stack
+// [SECTION] Parallel RenderPrimitives
 //-----------------------------------------------------------------------------
+// Produces the same draw list as RenderPrimitivesEx, but generates the vertices on several threads:
+// 1. the culling test runs on parallel chunks, and a prefix sum over the survivors gives each primitive its output slot,
+// 2. the reservations of RenderPrimitivesEx are replayed from the survivor counts, so draw commands are split at the same places,
+// 3. the threads write the surviving primitives into disjoint slices of the reserved buffers.
+// Besides Render, the renderer must provide Visible(cull_rect, prim) and Write(vtx, idx, vtx_idx, prim).
 
-// Copied and modified from PlotBarsHEx in implot_items.cpp
-template <typename Getter1, typename Getter2>
-void plot_bars_stack_ex(std::string label_id, const Getter1& getter1, const Getter2& getter2, double height, ImU32 bar_color, ImPlotBarsFlags flags) {
-    if (ImPlot::BeginItemEx(label_id.c_str(), FitterBarH<Getter1, Getter2>(getter1, getter2, height), flags, ImPlotCol_Fill)) {
-        if (getter1.count <= 0 || getter2.count <= 0) {
-            end_item();
-            return;
+static const unsigned int PARALLEL_MIN_PRIMS   = 1 << 15;
+static const int          PARALLEL_MAX_THREADS = 8;
+
+// A run of primitives sharing one reservation, with the buffer position of its first survivor
+struct ParallelBlock {
+    unsigned int prim_first;
+    int vtx_offset;
+    int idx_offset;
+    unsigned int vtx_idx;
+};
+
+struct ParallelBuffers {
+    ImVector<unsigned int> slots; // slots[i] is the number of survivors before primitive i, slots[prims] the total
+    ImVector<ParallelBlock> blocks;
+};
+
+static ParallelBuffers& get_parallel_buffers() {
+    static ParallelBuffers buffers;
+    return buffers;
+}
+
+static int parallel_thread_count() {
+    static const int count = ImClamp((int)std::thread::hardware_concurrency(), 1, PARALLEL_MAX_THREADS);
+    return count;
+}
+
+// Worker threads started on the first parallel call and kept until exit, so parallel_for neither creates threads
+// nor allocates their state on every frame. Jobs are only submitted from the ImGui thread.
+struct ParallelPool {
+    ParallelPool(int thread_count) : job(nullptr), context(nullptr), chunk_count(0), pending(0), generation(0), stop(false), thread_count(thread_count) {
+        for (int t = 1; t < thread_count; ++t)
+            workers[t] = std::thread([this, t] { work(t); });
+    }
+    ~ParallelPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        start.notify_all();
+        for (int t = 1; t < thread_count; ++t)
+            workers[t].join();
+    }
+    // Calls job(context, chunk) for chunks [0, chunks), the calling thread takes chunk 0
+    void run(int chunks, void (*new_job)(void*, int), void* new_context) {
+        IM_ASSERT(chunks <= thread_count);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = new_job;
+            context = new_context;
+            chunk_count = chunks;
+            pending = chunks - 1;
+            generation++;
+        }
+        start.notify_all();
+        new_job(new_context, 0);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+    }
+    void work(int chunk) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            start.wait(lock, [&] { return stop || generation != seen; });
+            if (stop)
+                return;
+            seen = generation;
+            if (chunk >= chunk_count)
+                continue;
+            void (*current_job)(void*, int) = job;
+            void* current_context = context;
+            lock.unlock();
+            current_job(current_context, chunk);
+            lock.lock();
+            if (--pending == 0)
+                done.notify_one();
         }
-        RenderPrimitives2<RendererBarsFillH>(getter1, getter2, bar_color, height);
-        end_item();
     }
+
+    std::mutex              mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    void                  (*job)(void*, int);
+    void*                   context;
+    int                     chunk_count;
+    int                     pending;
+    uint64_t                generation;
+    bool                    stop;
+    const int               thread_count;
+    std::thread             workers[PARALLEL_MAX_THREADS];
+};
+
+static ParallelPool& get_parallel_pool() {
+    static ParallelPool pool(parallel_thread_count());
+    return pool;
 }
 
-// Copied and modified from PlotBarGroups in implot_items.cpp
-template <typename T1, typename T2>
-void plot_bar_stack(std::string label_id, const T1* bar_length, std::vector<T2> bar_value, int item_count, double group_size, double shift, ImPlotBarGroupsFlags flags) {
-    const bool horz = ImHasFlag(flags, ImPlotBarGroupsFlags_Horizontal);
-    const bool stack = ImHasFlag(flags, ImPlotBarGroupsFlags_Stacked);
-    int group_count = 1;
-    ImPlot::SetupLock();
-    ImPlotContext& gp = *GImPlot;
-    gp.TempDouble1.resize(4 * group_count);
-    double* temp = gp.TempDouble1.Data;
-    double* neg = &temp[0];
-    double* pos = &temp[group_count];
-    double* curr_min = &temp[group_count * 2];
-    double* curr_max = &temp[group_count * 3];
-    for (int g = 0; g < 2; ++g)
-        temp[g] = 0;
-    if (horz) {
-        for (int i = 0; i < item_count; ++i) {
-            double v = (double)bar_length[i];
-            if (!is_item_hidden(label_id.c_str())) {
-
-                if (v > 0) {
-                    curr_min[0] = pos[0];
-                    curr_max[0] = curr_min[0] + v;
-                    pos[0] += v;
-                }
-                else {
-                    curr_max[0] = neg[0];
-                    curr_min[0] = curr_max[0] + v;
-                    neg[0] += v;
-                }
+template <typename Job>
+void call_parallel_job(void* context, int chunk) {
+    (*(const Job*)context)(chunk);
+}
+
+// Calls func(first, last, chunk) for thread_count equal chunks of [0, count), the calling thread takes chunk 0
+template <typename Func>
+void parallel_for(unsigned int count, int thread_count, const Func& func) {
+    auto chunk_first = [&](int chunk) { return (unsigned int)((ImU64)count * chunk / thread_count); };
+    auto job = [&](int chunk) { func(chunk_first(chunk), chunk_first(chunk + 1), chunk); };
+    get_parallel_pool().run(thread_count, call_parallel_job<decltype(job)>, (void*)&job);
+}
+
+template <class _Renderer>
+void RenderPrimitivesParallel(const _Renderer& renderer, ImDrawList& draw_list, const ImRect& cull_rect) {
+    const unsigned int prims = renderer.prims;
+    const int thread_count = parallel_thread_count();
+    if (prims < PARALLEL_MIN_PRIMS || thread_count < 2) {
+        RenderPrimitivesEx(renderer, draw_list, cull_rect);
+        return;
+    }
+    renderer.Init(draw_list);
+    ParallelBuffers& buffers = get_parallel_buffers();
+    buffers.slots.resize(prims + 1);
+    unsigned int* slots = buffers.slots.Data;
+
+    // count the survivors of each chunk, slots first hold the offsets within the chunk
+    unsigned int chunk_offsets[PARALLEL_MAX_THREADS];
+    parallel_for(prims, thread_count, [&](unsigned int first, unsigned int last, int chunk) {
+        unsigned int survivors = 0;
+        for (unsigned int i = first; i != last; ++i) {
+            slots[i] = survivors;
+            if (renderer.Visible(cull_rect, i))
+                survivors++;
+        }
+        chunk_offsets[chunk] = survivors;
+    });
+    unsigned int total = 0;
+    for (int t = 0; t < thread_count; ++t) {
+        const unsigned int survivors = chunk_offsets[t];
+        chunk_offsets[t] = total;
+        total += survivors;
+    }
+    slots[prims] = total;
+    parallel_for(prims, thread_count, [&](unsigned int first, unsigned int last, int chunk) {
+        for (unsigned int i = first; i != last; ++i)
+            slots[i] += chunk_offsets[chunk];
+    });
+
+    // replay the reservations of RenderPrimitivesEx, advancing the cursors by the survivors of each block
+    buffers.blocks.resize(0);
+    unsigned int remaining = prims;
+    unsigned int prims_culled = 0;
+    unsigned int idx = 0;
+    while (remaining) {
+        unsigned int cnt = ImMin(remaining, (MaxIdx<ImDrawIdx>::value - draw_list._VtxCurrentIdx) / renderer.vtx_consumed);
+        if (cnt >= ImMin(64u, remaining)) {
+            if (prims_culled >= cnt)
+                prims_culled -= cnt;
+            else {
+                prim_reserve(draw_list, (cnt - prims_culled) * renderer.idx_consumed, (cnt - prims_culled) * renderer.vtx_consumed);
+                prims_culled = 0;
+            }
+        }
+        else
+        {
+            if (prims_culled > 0) {
+                prim_unreserve(draw_list, prims_culled * renderer.idx_consumed, prims_culled * renderer.vtx_consumed);
+                prims_culled = 0;
             }
-            GetterXY<IndexerIdx<double>, IndexerLin> getter1(IndexerIdx<double>(curr_min, 1), IndexerLin(1.0, shift), 1);
-            GetterXY<IndexerIdx<double>, IndexerLin> getter2(IndexerIdx<double>(curr_max, 1), IndexerLin(1.0, shift), 1);
-            auto color_for_v = get_color_based_on_value<T2>(bar_value[i]);
-            plot_bars_stack_ex(label_id, getter1, getter2, group_size, color_for_v, 0);
+            cnt = ImMin(remaining, MaxIdx<ImDrawIdx>::value / renderer.vtx_consumed);
+            prim_reserve(draw_list, cnt * renderer.idx_consumed, cnt * renderer.vtx_consumed);
+        }
+        remaining -= cnt;
+        ParallelBlock block;
+        block.prim_first = idx;
+        block.vtx_offset = (int)(draw_list._VtxWritePtr - draw_list.VtxBuffer.Data);
+        block.idx_offset = (int)(draw_list._IdxWritePtr - draw_list.IdxBuffer.Data);
+        block.vtx_idx = draw_list._VtxCurrentIdx;
+        buffers.blocks.push_back(block);
+        const unsigned int survivors = slots[idx + cnt] - slots[idx];
+        draw_list._VtxWritePtr += survivors * renderer.vtx_consumed;
+        draw_list._IdxWritePtr += survivors * renderer.idx_consumed;
+        draw_list._VtxCurrentIdx += survivors * renderer.vtx_consumed;
+        prims_culled += cnt - survivors;
+        idx += cnt;
+    }
+    if (prims_culled > 0)
+        prim_unreserve(draw_list, prims_culled * renderer.idx_consumed, prims_culled * renderer.vtx_consumed);
+    stats_render(prims, prims - total);
+
+    // the buffers are not reallocated anymore, each thread fills the slots of its own primitives
+    ImDrawVert* vtx_data = draw_list.VtxBuffer.Data;
+    ImDrawIdx* idx_data = draw_list.IdxBuffer.Data;
+    const ParallelBlock* blocks = buffers.blocks.Data;
+    const int block_count = buffers.blocks.Size;
+    parallel_for(prims, thread_count, [&](unsigned int first, unsigned int last, int) {
+        int b = (int)(std::upper_bound(blocks, blocks + block_count, first,
+            [](unsigned int prim, const ParallelBlock& block) { return prim < block.prim_first; }) - blocks) - 1;
+        for (unsigned int i = first; i != last; ++i) {
+            if (slots[i + 1] == slots[i])
+                continue; // culled
+            while (b + 1 < block_count && blocks[b + 1].prim_first <= i)
+                ++b;
+            const ParallelBlock& block = blocks[b];
+            const unsigned int k = slots[i] - slots[block.prim_first];
+            renderer.Write(vtx_data + block.vtx_offset + k * renderer.vtx_consumed,
+                           idx_data + block.idx_offset + k * renderer.idx_consumed,
+                           block.vtx_idx + k * renderer.vtx_consumed, i);
+        }
+    });
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Level of detail
+//-----------------------------------------------------------------------------
+// When a stack has more segments than the plot has pixels, most segments are narrower than a pixel.
+// All consecutive sub-pixel segments that fall into the same pixel column are collapsed into one aggregated bar,
+// so the number of generated quads is bounded by the plot width instead of the number of segments.
+
+static const ImU32 LOD_MARKER_COLOR = IM_COL32(128, 128, 128, 255);
+static const int   LOD_MAX_COLORS   = 8;
+static const float LOD_TIE_RATIO    = 1.0f + 1.0f / 64; // weight a later color needs over the dominant one to replace it, so rounding does not pick between equal durations
+
+// Picks the color drawn for a pixel column (or a pyramid run) holding several colors with the given weights
+template <typename W>
+ImU32 lod_resolve_color(const ImU32* colors, const W* weights, int color_count, ImPlotBarGroupsFlags flags) {
+    if (color_count == 1)
+        return colors[0];
+    if (ImHasFlag(flags, BarStackFlags_LodMarker))
+        return LOD_MARKER_COLOR;
+    if (ImHasFlag(flags, BarStackFlags_LodBlend)) {
+        double total = 0;
+        double rgba[4] = { 0, 0, 0, 0 };
+        for (int c = 0; c < color_count; ++c) {
+            total += weights[c];
+            for (int ch = 0; ch < 4; ++ch)
+                rgba[ch] += weights[c] * ((colors[c] >> (ch * 8)) & 0xFF);
+        }
+        if (total > 0) {
+            ImU32 out = 0;
+            for (int ch = 0; ch < 4; ++ch)
+                out |= (ImU32)(rgba[ch] / total + 0.5) << (ch * 8);
+            return out;
+        }
+    }
+    int dominant = 0;
+    for (int c = 1; c < color_count; ++c) {
+        if (weights[c] > weights[dominant] * LOD_TIE_RATIO)
+            dominant = c;
+    }
+    return colors[dominant];
+}
+
+// Adds weight to col in a small color histogram, colors beyond max_colors are dropped
+template <typename W>
+void lod_add_color(ImU32* colors, W* weights, int* color_count, int max_colors, ImU32 col, W weight) {
+    for (int c = 0; c < *color_count; ++c) {
+        if (colors[c] == col) {
+            weights[c] += weight;
+            return;
+        }
+    }
+    if (*color_count < max_colors) {
+        colors[*color_count] = col;
+        weights[*color_count] = weight;
+        ++*color_count;
+    }
+}
+
+struct LodBucket {
+    void Reset(int col_idx) {
+        column = col_idx;
+        count = 0;
+        color_count = 0;
+    }
+    void Add(float px_min, float px_max, ImU32 col) {
+        if (count == 0) {
+            min = px_min;
+            max = px_max;
+        }
+        else {
+            min = ImMin(min, px_min);
+            max = ImMax(max, px_max);
+        }
+        count++;
+        // colors beyond LOD_MAX_COLORS are dropped from the bucket, they can only be a minor share of one pixel
+        lod_add_color(colors, weights, &color_count, LOD_MAX_COLORS, col, px_max - px_min);
+    }
+    ImU32 Color(ImPlotBarGroupsFlags flags) const {
+        return lod_resolve_color(colors, weights, color_count, flags);
+    }
+    float min, max;
+    int column;
+    int count;
+    ImU32 colors[LOD_MAX_COLORS];
+    float weights[LOD_MAX_COLORS];
+    int color_count;
+};
+
+// Scratch buffers for the aggregated bars, reused across calls like ImPlotContext::TempDouble1
+struct LodBuffers {
+    ImVector<float> min;
+    ImVector<float> max;
+    ImVector<ImU32> colors;
+};
+
+static LodBuffers& get_lod_buffers() {
+    static LodBuffers buffers;
+    return buffers;
+}
+
+static void lod_flush(const LodBucket& bucket, ImPlotBarGroupsFlags flags, LodBuffers& out) {
+    if (bucket.count == 0)
+        return;
+    out.min.push_back(bucket.min);
+    out.max.push_back(bucket.max);
+    out.colors.push_back(bucket.Color(flags));
+}
+
+// Fills out with the aggregated bars of count segments given in pixel space, returns the number of bars.
+// Pixel columns start where px + column_phase is a whole number, column_phase is 0 unless px is relative to a point between two pixels.
+static int lod_aggregate(const float* px_min, const float* px_max, const ImU32* colors, int count, float column_phase, ImPlotBarGroupsFlags flags, LodBuffers& out) {
+    out.min.resize(0);
+    out.max.resize(0);
+    out.colors.resize(0);
+    LodBucket bucket;
+    bucket.Reset(0);
+    for (int i = 0; i < count; ++i) {
+        if (px_max[i] - px_min[i] >= 1.0f) {
+            // wide enough to be drawn on its own
+            lod_flush(bucket, flags, out);
+            bucket.Reset(0);
+            bucket.Add(px_min[i], px_max[i], colors[i]);
+            lod_flush(bucket, flags, out);
+            bucket.Reset(0);
+            continue;
+        }
+        const int column = (int)ImFloor(px_min[i] + column_phase);
+        if (bucket.count > 0 && bucket.column != column) {
+            lod_flush(bucket, flags, out);
+            bucket.Reset(column);
         }
+        bucket.column = column;
+        bucket.Add(px_min[i], px_max[i], colors[i]);
+    }
+    lod_flush(bucket, flags, out);
+    return out.min.Size;
+}
+
+// Resolves the color of each run of a pyramid level
+struct ColorerPyramid {
+    ColorerPyramid(const BarStackPyramidLevel& level, ImPlotBarGroupsFlags flags) : level(level), flags(flags) { }
+    template <typename I> ImU32 operator()(I idx) const {
+        const BarStackPyramidRun& run = level.runs[idx];
+        return lod_resolve_color(run.colors, run.weights, run.color_count, flags);
+    }
+    const BarStackPyramidLevel& level;
+    const ImPlotBarGroupsFlags flags;
+};
+
+//-----------------------------------------------------------------------------
+// [SECTION] Palettes
+//-----------------------------------------------------------------------------
+
+// Set by set_next_bar_stack_palette() and consumed by the next plot_bar_stack call, like ImPlotContext::NextItemData
+static BarStackPalette next_palette;
+static BarStackPalette active_palette; // palette of the stack being plotted, part of the keys of its cached output
+
+void set_next_bar_stack_palette(const BarStackPalette& palette) {
+    next_palette = palette;
+}
+
+// Calls func once with the palette policy of the next stack: the next palette if set, else stack_palette if set, else the defaults
+// of T, or PaletteDeep with BarStackFlags_Categorical
+template <typename T, typename F>
+void with_palette(const BarStackPalette& stack_palette, ImPlotBarGroupsFlags flags, F func) {
+    const BarStackPalette palette = next_palette.colors != nullptr ? next_palette : stack_palette;
+    next_palette = BarStackPalette();
+    active_palette = palette;
+    if (palette.colors != nullptr)
+        func(PaletteLut(palette));
+    else if (ImHasFlag(flags, BarStackFlags_Categorical))
+        func(PaletteDeep());
+    else
+        func(PaletteDefault<T>());
+}
+
+// True when the defaults of T are the colors BarStackFlags_Categorical asks for
+template <typename T>
+constexpr bool default_palette_is_categorical() {
+    return std::is_base_of<PaletteDeep, PaletteDefault<T>>::value;
+}
+
+static ImVector<ImU32>& get_color_buffer() {
+    static ImVector<ImU32> colors;
+    return colors;
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] BarStackIndex
+//-----------------------------------------------------------------------------
+
+BarStackIndex::BarStackIndex() : version(0), append_version(0), edit_version(0) {
+    clear();
+}
+
+void BarStackIndex::clear() {
+    version = next_version(version);
+    pos.resize(1);
+    pos[0] = 0;
+    neg.resize(0);
+}
+
+template <typename T>
+void BarStackIndex::build(const T* bar_length, int count, int offset, int stride) {
+    clear();
+    with_bar_stack_layout<T>(count, offset, stride, [&](auto layout) {
+        const BarStackIndexer<T, decltype(layout)::value> indexer(bar_length, count, offset, stride);
+        // plain prefix sum until the first negative length, which unsigned lengths never have
+        pos.resize(count + 1);
+        double* sums = pos.Data;
+        double sum = 0;
+        int i = 0;
+        for (; i < count; ++i) {
+            const T length = indexer(i);
+            if constexpr (std::is_signed<T>::value || std::is_floating_point<T>::value) {
+                if (length < 0)
+                    break;
+            }
+            sum += length > 0 ? (double)length : 0.0;
+            sums[i + 1] = sum;
+        }
+        pos.resize(i + 1);
+        for (; i < count; ++i)
+            append((double)indexer(i));
+    });
+}
+
+void BarStackIndex::append(double bar_length) {
+    // version moved since the last append, so the data was changed otherwise in between
+    if (version != append_version)
+        edit_version = version;
+    version = next_version(version);
+    append_version = version;
+    if (bar_length < 0 && neg.empty())
+        neg.resize(pos.Size, 0.0);
+    pos.push_back(pos.back() + (bar_length > 0 ? bar_length : 0));
+    if (!neg.empty())
+        neg.push_back(neg.back() + (bar_length < 0 ? bar_length : 0));
+}
+
+void BarStackIndex::find_visible(double x_min, double x_max, int* first, int* last) const {
+    // pos is non-decreasing: segment i is visible if pos[i + 1] >= x_min and pos[i] <= x_max
+    *first = (int)(std::lower_bound(pos.begin() + 1, pos.end(), x_min) - (pos.begin() + 1));
+    *last = (int)(std::upper_bound(pos.begin(), pos.end() - 1, x_max) - pos.begin());
+    if (neg.empty())
+        return;
+    // neg is non-increasing: segment i is visible if neg[i + 1] <= x_max and neg[i] >= x_min
+    const int neg_first = (int)(std::lower_bound(neg.begin() + 1, neg.end(), x_max, std::greater<double>()) - (neg.begin() + 1));
+    const int neg_last = (int)(std::upper_bound(neg.begin(), neg.end() - 1, x_min, std::greater<double>()) - neg.begin());
+    if (neg_first >= neg_last)
+        return;
+    if (*first >= *last) {
+        *first = neg_first;
+        *last = neg_last;
+    }
+    else {
+        *first = ImMin(*first, neg_first);
+        *last = ImMax(*last, neg_last);
+    }
+}
+
+template void BarStackIndex::build<float>(const float* bar_length, int count, int offset, int stride);
+template void BarStackIndex::build<double>(const double* bar_length, int count, int offset, int stride);
+template void BarStackIndex::build<int32_t>(const int32_t* bar_length, int count, int offset, int stride);
+template void BarStackIndex::build<uint32_t>(const uint32_t* bar_length, int count, int offset, int stride);
+template void BarStackIndex::build<int64_t>(const int64_t* bar_length, int count, int offset, int stride);
+template void BarStackIndex::build<uint64_t>(const uint64_t* bar_length, int count, int offset, int stride);
+
+//-----------------------------------------------------------------------------
+// [SECTION] BarStackPyramid
+//-----------------------------------------------------------------------------
+
+void BarStackPyramidLevel::append(uint64_t origin, int segment, uint64_t start, uint64_t duration, ImU32 color) {
+    if (skipped)
+        return;
+    if (version != append_version)
+        edit_version = version;
+    version = next_version(version);
+    append_version = version;
+    const uint64_t bin = duration < bin_width ? (start - origin) / bin_width : UINT64_MAX;
+    if (bin != UINT64_MAX && !runs.empty() && runs.back().bin == bin) {
+        BarStackPyramidRun& run = runs.back();
+        run.end = start + duration;
+        lod_add_color(run.colors, run.weights, &run.color_count, BAR_STACK_PYRAMID_COLORS, color, (float)duration);
+        return;
+    }
+    BarStackPyramidRun run;
+    run.start = start;
+    run.end = start + duration;
+    run.bin = bin;
+    run.colors[0] = color;
+    run.weights[0] = (float)duration;
+    run.color_count = 1;
+    run.first = segment;
+    runs.push_back(run);
+}
+
+bool BarStackPyramidLevel::extend(uint64_t origin, uint64_t start, uint64_t old_duration, uint64_t duration, ImU32 color) {
+    if (skipped)
+        return true;
+    IM_ASSERT(!runs.empty() && duration >= old_duration);
+    BarStackPyramidRun& run = runs.back();
+    // the bin of a short segment only depends on its start, so it either stays in its run or becomes long
+    const uint64_t bin = duration < bin_width ? (start - origin) / bin_width : UINT64_MAX;
+    if (run.bin != bin)
+        return false;
+    if (version != append_version)
+        edit_version = version;
+    version = next_version(version);
+    append_version = version;
+    run.end = start + duration;
+    // a long segment is alone in its run
+    if (bin == UINT64_MAX)
+        run.weights[0] = (float)duration;
+    else
+        lod_add_color(run.colors, run.weights, &run.color_count, BAR_STACK_PYRAMID_COLORS, color, (float)(duration - old_duration));
+    return true;
+}
+
+void BarStackPyramidLevel::find_visible(double x_min, double x_max, int* first, int* last) const {
+    // runs are contiguous, so both starts and ends are non-decreasing
+    auto before = [](double x, const BarStackPyramidRun& run) { return x < (double)run.start; };
+    const int after_min = (int)(std::upper_bound(runs.begin(), runs.end(), x_min, before) - runs.begin());
+    *first = ImMax(after_min - 1, 0);
+    if (*first < count() && segment_max(*first) < x_min)
+        ++*first;
+    *last = (int)(std::upper_bound(runs.begin(), runs.end(), x_max, before) - runs.begin());
+}
+
+int BarStackPyramid::pick_level(double pixels_per_unit) const {
+    int level = -1;
+    for (int l = 0; l < level_count && (double)levels[l].bin_width * pixels_per_unit <= 1.0; ++l) {
+        if (!levels[l].skipped)
+            level = l;
+    }
+    return level;
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] BarStackTimeline
+//-----------------------------------------------------------------------------
+
+static const int PYRAMID_SKIP_MIN_SEGMENTS = 1024; // segments a timeline needs before its levels may be skipped, shorter ones tell little
+
+// Appends segments [first, count) of timeline to level
+template <typename T, typename _Palette>
+void append_pyramid_level(BarStackPyramidLevel& level, const BarStackTimeline<T>& timeline, int first, const _Palette& palette) {
+    for (int i = first; i < timeline.count(); ++i)
+        level.append(timeline.origin, i, timeline.starts[i], timeline.durations[i], palette(timeline.states[i]));
+}
+
+// Skips the levels keeping more than 3/4 of the runs of the finer level they are built next to, or of the segments for the
+// finest one: they cost about as much to draw as that level and their memory is better freed.
+// The segments of a growing timeline may merge better later on, so the skipped levels are built again each time it doubles.
+template <typename T, typename _Palette>
+void skip_pyramid_levels(BarStackTimeline<T>& timeline, const _Palette& palette) {
+    BarStackPyramid& pyramid = timeline.pyramid;
+    if (timeline.count() < PYRAMID_SKIP_MIN_SEGMENTS)
+        return;
+    if (timeline.count() >= 2 * (int64_t)pyramid.revisit_count) {
+        pyramid.revisit_count = timeline.count();
+        for (int l = 0; l < pyramid.level_count; ++l) {
+            BarStackPyramidLevel& level = pyramid.levels[l];
+            if (!level.skipped)
+                continue;
+            level.skipped = false;
+            level.runs.resize(0);
+            level.version = next_version(level.version);
+            append_pyramid_level(level, timeline, 0, palette);
+        }
+    }
+    int finer = timeline.count();
+    for (int l = 0; l < pyramid.level_count; ++l) {
+        BarStackPyramidLevel& level = pyramid.levels[l];
+        if (level.skipped)
+            continue;
+        if ((int64_t)level.runs.Size * 4 > (int64_t)finer * 3) {
+            level.skipped = true;
+            level.runs.clear();
+            level.version = next_version(level.version);
+            continue;
+        }
+        finer = level.runs.Size;
+    }
+}
+
+// Adds segments [first, count) to every pyramid level, then adds coarser levels until the coarsest bin spans the whole timeline
+template <typename T, typename _Palette>
+void update_pyramid_levels(BarStackTimeline<T>& timeline, int first, const _Palette& palette) {
+    BarStackPyramid& pyramid = timeline.pyramid;
+    for (int l = 0; l < pyramid.level_count; ++l)
+        append_pyramid_level(pyramid.levels[l], timeline, first, palette);
+    const uint64_t span = timeline.end() - timeline.origin;
+    // the bin width doubles with every level, no level is added once it would overflow
+    while (pyramid.level_count < BAR_STACK_PYRAMID_MAX_LEVELS && pyramid.base_width <= (UINT64_MAX >> pyramid.level_count) &&
+           (pyramid.level_count == 0 || pyramid.levels[pyramid.level_count - 1].bin_width < span)) {
+        BarStackPyramidLevel& level = pyramid.levels[pyramid.level_count++];
+        level.bin_width = pyramid.base_width << (pyramid.level_count - 1);
+        level.skipped = false;
+        level.runs.resize(0);
+        level.version = next_version(level.version);
+        append_pyramid_level(level, timeline, 0, palette);
+    }
+    skip_pyramid_levels(timeline, palette);
+}
+
+template <typename T>
+void update_pyramid(BarStackTimeline<T>& timeline, int first) {
+    if (timeline.palette.colors != nullptr)
+        update_pyramid_levels(timeline, first, PaletteLut(timeline.palette));
+    else
+        update_pyramid_levels(timeline, first, PaletteDefault<T>());
+}
+
+// Grows the last segment of timeline from old_duration in every pyramid level, then adds the coarser levels the longer span needs
+template <typename T, typename _Palette>
+void extend_pyramid_levels(BarStackTimeline<T>& timeline, uint64_t old_duration, const _Palette& palette) {
+    BarStackPyramid& pyramid = timeline.pyramid;
+    const int last = timeline.count() - 1;
+    for (int l = 0; l < pyramid.level_count; ++l) {
+        BarStackPyramidLevel& level = pyramid.levels[l];
+        if (level.extend(timeline.origin, timeline.starts[last], old_duration, timeline.durations[last], palette(timeline.states[last])))
+            continue;
+        // grown past the bin width, the segment leaves the run of short segments it was merged into, which is built again
+        // without it, including zero length segments merged at its start
+        const int first = level.runs.back().first;
+        level.runs.pop_back();
+        append_pyramid_level(level, timeline, first, palette);
+    }
+    update_pyramid_levels(timeline, timeline.count(), palette);
+}
+
+// Extends the last segment of timeline to end at new_end, an append as far as the caches are concerned
+template <typename T>
+void extend_last_segment(BarStackTimeline<T>& timeline, uint64_t new_end) {
+    if (timeline.durations.empty() || new_end <= timeline.end())
+        return;
+    if (timeline.version != timeline.append_version)
+        timeline.edit_version = timeline.version;
+    timeline.version = next_version(timeline.version);
+    timeline.append_version = timeline.version;
+    const uint64_t old_duration = timeline.durations.back();
+    timeline.durations.back() = new_end - timeline.starts.back();
+    if (!timeline.pyramid.enabled())
+        return;
+    if (timeline.palette.colors != nullptr)
+        extend_pyramid_levels(timeline, old_duration, PaletteLut(timeline.palette));
+    else
+        extend_pyramid_levels(timeline, old_duration, PaletteDefault<T>());
+}
+
+template <typename T>
+BarStackTimeline<T>::BarStackTimeline(uint64_t origin) : origin(origin), has_open(false), version(next_version(0)), append_version(0), edit_version(0) { }
+
+template <typename T>
+void BarStackTimeline<T>::clear() {
+    version = next_version(version);
+    starts.resize(0);
+    durations.resize(0);
+    states.resize(0);
+    has_open = false;
+    for (int l = 0; l < pyramid.level_count; ++l) {
+        pyramid.levels[l].runs.resize(0);
+        pyramid.levels[l].version = next_version(pyramid.levels[l].version);
+    }
+    pyramid.level_count = 0;
+    pyramid.revisit_count = 0;
+}
+
+template <typename T>
+void BarStackTimeline<T>::reserve(int capacity) {
+    starts.reserve(capacity);
+    durations.reserve(capacity);
+    states.reserve(capacity);
+}
+
+template <typename T>
+void BarStackTimeline<T>::append(uint64_t duration, T state) {
+    if (version != append_version)
+        edit_version = version;
+    version = next_version(version);
+    append_version = version;
+    starts.push_back(end());
+    durations.push_back(duration);
+    states.push_back(state);
+    has_open = false;
+    if (pyramid.enabled())
+        update_pyramid(*this, count() - 1);
+}
+
+template <typename T>
+void BarStackTimeline<T>::set_palette(const BarStackPalette& new_palette) {
+    palette = new_palette;
+    version = next_version(version);
+    if (pyramid.enabled())
+        enable_pyramid(pyramid.base_width);
+}
+
+template <typename T>
+void BarStackTimeline<T>::enable_pyramid(uint64_t base_width) {
+    IM_ASSERT(base_width > 0);
+    pyramid.base_width = base_width;
+    pyramid.level_count = 0;
+    pyramid.revisit_count = 0;
+    update_pyramid(*this, count());
+}
+
+template <typename T>
+void BarStackTimeline<T>::push_transition(uint64_t timestamp, T state) {
+    if (durations.empty())
+        origin = timestamp;
+    // the last segment reaches the sample, also one added by append(), so segments stay contiguous.
+    // Late samples are clamped so the timeline never runs backwards
+    extend_last_segment(*this, timestamp);
+    // a sample of the last state only extends it, another state opens a new segment at the end of the last one
+    if (durations.empty() || state != states.back())
+        append(0, state);
+    has_open = true;
+}
+
+// Shared by BarStackTimeline and BarStackTimelineView: segments are contiguous, so both starts and ends are non-decreasing
+static void find_visible_segments(const uint64_t* starts, const uint64_t* durations, int count, double x_min, double x_max, int* first, int* last) {
+    auto before = [](double x, uint64_t start) { return x < (double)start; };
+    const int after_min = (int)(std::upper_bound(starts, starts + count, x_min, before) - starts);
+    *first = ImMax(after_min - 1, 0);
+    if (*first < count && (double)(starts[*first] + durations[*first]) < x_min)
+        ++*first;
+    *last = (int)(std::upper_bound(starts, starts + count, x_max, before) - starts);
+}
+
+template <typename T>
+void BarStackTimeline<T>::find_visible(double x_min, double x_max, int* first, int* last) const {
+    find_visible_segments(starts.Data, durations.Data, count(), x_min, x_max, first, last);
+}
+
+template <typename T>
+void BarStackTimelineView<T>::find_visible(double x_min, double x_max, int* first, int* last) const {
+    find_visible_segments(starts, durations, segments, x_min, x_max, first, last);
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Compressed Timeline
+//-----------------------------------------------------------------------------
+// Frame of reference bit packing: every value of a block is stored as its difference to the smallest value of the block,
+// with as many bits as the largest difference needs. Values are read with one unaligned word load each.
+
+static int bits_needed(uint64_t value) {
+    int bits = 0;
+    for (; value != 0; value >>= 1)
+        bits++;
+    return bits;
+}
+
+static uint64_t load_word(const unsigned char* at) {
+    uint64_t word;
+    memcpy(&word, at, sizeof(word));
+    return word;
+}
+
+// ORs the low bits of value into out at bit position pos, in chunks of at most 32 bits so a chunk always fits a word load
+static void write_bits(unsigned char* out, uint64_t pos, uint64_t value, int bits) {
+    for (int done = 0; done < bits; done += 32) {
+        const int chunk_bits = ImMin(bits - done, 32);
+        const uint64_t chunk = (value >> done) & ((1ull << chunk_bits) - 1);
+        const uint64_t at = pos + done;
+        const uint64_t word = load_word(out + (at >> 3)) | (chunk << (at & 7));
+        memcpy(out + (at >> 3), &word, sizeof(word));
+    }
+}
+
+static uint64_t read_bits(const unsigned char* in, uint64_t pos, int bits) {
+    if (bits <= 56)
+        return (load_word(in + (pos >> 3)) >> (pos & 7)) & ((1ull << bits) - 1);
+    return read_bits(in, pos, 32) | (read_bits(in, pos + 32, bits - 32) << 32);
+}
+
+static int packed_bytes(int count, int bits) {
+    return (int)(((int64_t)count * bits + 7) / 8);
+}
+
+// Packs the full tail of timeline into a new block
+template <typename T>
+void pack_tail(BarStackCompressedTimeline<T>& timeline) {
+    const int count = BAR_STACK_BLOCK_SEGMENTS;
+    IM_ASSERT(timeline.tail_durations.Size == count);
+    const uint64_t* durations = timeline.tail_durations.Data;
+    const T* states = timeline.tail_states.Data;
+    uint64_t duration_min = durations[0], duration_max = durations[0];
+    T state_min = states[0], state_max = states[0];
+    for (int i = 1; i < count; ++i) {
+        duration_min = ImMin(duration_min, durations[i]);
+        duration_max = ImMax(duration_max, durations[i]);
+        state_min = ImMin(state_min, states[i]);
+        state_max = ImMax(state_max, states[i]);
+    }
+    BarStackBlock block;
+    block.start = timeline.tail_start;
+    block.end = timeline.end_time;
+    block.duration_base = duration_min;
+    // the differences of signed states are taken modulo 2^64, which keeps them exact
+    block.state_base = (uint64_t)state_min;
+    block.duration_bits = (ImU8)bits_needed(duration_max - duration_min);
+    block.state_bits = (ImU8)bits_needed((uint64_t)state_max - (uint64_t)state_min);
+    const int duration_bytes = packed_bytes(count, block.duration_bits);
+    const int state_bytes = packed_bytes(count, block.state_bits);
+    // the 8 zero bytes of padding at the end of bytes become the start of the block
+    block.offset = timeline.bytes.size() - 8;
+    timeline.bytes.resize((size_t)block.offset + duration_bytes + state_bytes + 8);
+    unsigned char* out = timeline.bytes.data() + block.offset;
+    memset(out, 0, duration_bytes + state_bytes + 8);
+    for (int i = 0; i < count; ++i)
+        write_bits(out, (uint64_t)i * block.duration_bits, durations[i] - duration_min, block.duration_bits);
+    out += duration_bytes;
+    for (int i = 0; i < count; ++i)
+        write_bits(out, (uint64_t)i * block.state_bits, (uint64_t)states[i] - (uint64_t)state_min, block.state_bits);
+    timeline.blocks.push_back(block);
+    timeline.tail_durations.resize(0);
+    timeline.tail_states.resize(0);
+    timeline.tail_start = timeline.end_time;
+}
+
+template <typename T>
+BarStackCompressedTimeline<T>::BarStackCompressedTimeline(uint64_t origin) : origin(origin), tail_start(origin), end_time(origin), version(next_version(0)) {
+    bytes.resize(8);
+}
+
+template <typename T>
+void BarStackCompressedTimeline<T>::clear() {
+    version = next_version(version);
+    blocks.resize(0);
+    bytes.assign(8, 0);
+    tail_durations.resize(0);
+    tail_states.resize(0);
+    tail_start = origin;
+    end_time = origin;
+}
+
+template <typename T>
+void BarStackCompressedTimeline<T>::append(uint64_t duration, T state) {
+    version = next_version(version);
+    tail_durations.push_back(duration);
+    tail_states.push_back(state);
+    end_time += duration;
+    if (tail_durations.Size == BAR_STACK_BLOCK_SEGMENTS)
+        pack_tail(*this);
+}
+
+template <typename T>
+void BarStackCompressedTimeline<T>::decode(int idx, uint64_t* starts, uint64_t* durations, T* states) const {
+    const BarStackBlock& block = blocks[idx];
+    const unsigned char* in = bytes.data() + block.offset;
+    uint64_t start = block.start;
+    for (int i = 0; i < BAR_STACK_BLOCK_SEGMENTS; ++i) {
+        const uint64_t duration = block.duration_base + read_bits(in, (uint64_t)i * block.duration_bits, block.duration_bits);
+        starts[i] = start;
+        durations[i] = duration;
+        start += duration;
+    }
+    in += packed_bytes(BAR_STACK_BLOCK_SEGMENTS, block.duration_bits);
+    for (int i = 0; i < BAR_STACK_BLOCK_SEGMENTS; ++i)
+        states[i] = (T)(block.state_base + read_bits(in, (uint64_t)i * block.state_bits, block.state_bits));
+}
+
+template <typename T>
+void BarStackCompressedTimeline<T>::find_blocks(double x_min, double x_max, int* first, int* last) const {
+    // blocks are contiguous like segments, so both their starts and ends are non-decreasing
+    const BarStackBlock* begin = blocks.Data;
+    const BarStackBlock* end = blocks.Data + blocks.Size;
+    *first = (int)(std::lower_bound(begin, end, x_min, [](const BarStackBlock& block, double x) { return (double)block.end < x; }) - begin);
+    *last = (int)(std::upper_bound(begin, end, x_max, [](double x, const BarStackBlock& block) { return x < (double)block.start; }) - begin);
+}
+
+template <typename T>
+size_t BarStackCompressedTimeline<T>::memory_size() const {
+    return blocks.size_in_bytes() + bytes.size() + tail_durations.size_in_bytes() + tail_states.size_in_bytes();
+}
+
+// Segments of the blocks of a compressed timeline overlapping the view, decoded into columns and kept per item.
+// The extents are those of the whole timeline, so fitting does not depend on which blocks are decoded.
+template <typename T>
+struct DecodedBlocks {
+    DecodedBlocks() : timeline(nullptr), first_block(0), last_block(0), tail(0), timeline_version(0), version(0) { }
+    int count() const { return starts.Size; }
+    double segment_min(int idx) const { return (double)starts[idx]; }
+    double segment_max(int idx) const { return (double)(starts[idx] + durations[idx]); }
+    double stack_min(int) const { return (double)timeline->origin; }
+    double stack_max(int) const { return (double)timeline->end(); }
+    void find_visible(double x_min, double x_max, int* first, int* last) const {
+        find_visible_segments(starts.Data, durations.Data, count(), x_min, x_max, first, last);
+    }
+
+    ImVector<uint64_t>                   starts;
+    ImVector<uint64_t>                   durations;
+    ImVector<T>                          states;
+    const BarStackCompressedTimeline<T>* timeline;
+    int                                  first_block;
+    int                                  last_block;
+    int                                  tail;             // segments of the tail decoded after the blocks
+    uint64_t                             timeline_version; // version of the timeline the blocks were decoded from
+    uint64_t                             version;          // incremented on every decode, the decoded segments move as the view scrolls
+};
+
+// Decodes the blocks overlapping [x_min, x_max] and the tail, unless they are already decoded
+template <typename T>
+void decode_visible_blocks(const BarStackCompressedTimeline<T>& timeline, double x_min, double x_max, DecodedBlocks<T>& decoded) {
+    int first, last;
+    timeline.find_blocks(x_min, x_max, &first, &last);
+    // the tail follows the last block, it is only decoded when the view overlaps it
+    const bool tail_visible = last == timeline.blocks.Size && x_max >= (double)timeline.tail_start && x_min <= (double)timeline.end_time;
+    const int tail = tail_visible ? timeline.tail_durations.Size : 0;
+    if (decoded.timeline == &timeline && decoded.timeline_version == timeline.version && decoded.first_block == first && decoded.last_block == last &&
+        decoded.tail == tail)
+        return;
+    decoded.timeline = &timeline;
+    decoded.timeline_version = timeline.version;
+    decoded.version = next_version(decoded.version);
+    decoded.first_block = first;
+    decoded.last_block = last;
+    decoded.tail = tail;
+    const int count = (last - first) * BAR_STACK_BLOCK_SEGMENTS + tail;
+    decoded.starts.resize(count);
+    decoded.durations.resize(count);
+    decoded.states.resize(count);
+    for (int b = first; b < last; ++b) {
+        const int at = (b - first) * BAR_STACK_BLOCK_SEGMENTS;
+        timeline.decode(b, decoded.starts.Data + at, decoded.durations.Data + at, decoded.states.Data + at);
+    }
+    uint64_t start = timeline.tail_start;
+    for (int i = 0, at = count - tail; i < tail; ++i, ++at) {
+        decoded.starts[at] = start;
+        decoded.durations[at] = timeline.tail_durations[i];
+        decoded.states[at] = timeline.tail_states[i];
+        start += timeline.tail_durations[i];
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// [SECTION] Runs
+//-----------------------------------------------------------------------------
+// Sampled data repeats a state over many segments in a row. Each stack keeps the first segment of every run of contiguous
+// segments of one color in a window around the view, one view width to each side, found once per version of its data and
+// extended on appends while the window reaches the end of the data. A frame then only converts the runs overlapping the view,
+// and the window is only looked at again once the view leaves it, so the cost stays bounded by the visible segments.
+// The runs are only looked for once the data stays unchanged for a call: data rebuilt on every call, like the index of raw
+// lengths, and data without enough repeats are merged in pixels every frame instead. Views are never looked at, their columns
+// may be mapped from a file and only the pages of the visible segments are meant to be read.
+
+static const int RUN_KEEP_LENGTH = 4; // the runs are used once they average this many segments
+static const int RUN_DROP_LENGTH = 2; // and no longer when they average less than this
+
+struct RunEntry {
+    RunEntry() : version(0), seen(0), first(0), last(0), count(0), valid(false), kept(false) { }
+    StackKey      key;
+    uint64_t      version; // version of the data the runs were found in
+    uint64_t      seen;    // version of the data at the last call
+    int           first;   // the runs cover segments [first, last)
+    int           last;
+    int           count;   // segments of the data when the runs were found
+    bool          valid;
+    bool          kept;    // the runs merge enough segments to be drawn instead of them
+    ImVector<int> starts;  // first segment of each run, at most three times the visible segments
+};
+
+static StackKey run_key(const void* data, ImPlotBarGroupsFlags flags) {
+    StackKey key;
+    key.data = data;
+    key.flags = flags;
+    key.palette = active_palette;
+    return key;
+}
+
+// True when segments were only appended to index, or its last segment extended, since it was at version.
+// Data without append_version, like a BarStackTimelineView, can only tell that it did not change.
+template <typename Index>
+static auto appended_since(const Index& index, uint64_t version, int) -> decltype(index.append_version, bool()) {
+    if (index.version == version)
+        return true;
+    return index.version == index.append_version && index.edit_version <= version;
+}
+
+template <typename Index>
+static bool appended_since(const Index& index, uint64_t version, long) {
+    return index.version == version;
+}
+
+// Runs are looked for in data held in memory, a view may read its columns from a mapped file
+template <typename Index>
+static bool scans_runs(const Index&) {
+    return true;
+}
+
+template <typename T>
+static bool scans_runs(const BarStackTimelineView<T>&) {
+    return false;
+}
+
+// Looks for runs in segments [from, to), segment from - 1 is already in the last run unless from is the first of the window
+template <typename Index, typename Colorer>
+static void run_scan(const Index& index, const Colorer& colorer, int from, int to, RunEntry& entry) {
+    ImU32 prev_color = from > entry.first ? colorer(from - 1) : 0;
+    for (int i = from; i < to; ++i) {
+        const ImU32 color = colorer(i);
+        // contiguous in either direction, negative lengths stack leftwards
+        const bool joined = i > entry.first && color == prev_color &&
+            (index.segment_min(i) == index.segment_max(i - 1) || index.segment_max(i) == index.segment_min(i - 1));
+        prev_color = color;
+        if (!joined)
+            entry.starts.push_back(i);
+    }
+    entry.last = to;
+    stats_scanned(to - from);
+}
+
+// Brings the runs kept for id up to date for the visible segments [first, last) of count, returns nullptr when the segments
+// have to be drawn one by one
+template <typename Index, typename Colorer>
+const RunEntry* update_runs(ImGuiID id, const Index& index, const Colorer& colorer, int count, int first, int last, ImPlotBarGroupsFlags flags) {
+    if (!scans_runs(index))
+        return nullptr;
+    // one entry per data, so switching between the levels of a pyramid does not look for the runs again
+    const void* data = &index;
+    RunEntry& entry = get_item_entry<RunEntry>(ImHashData(&data, sizeof(data), id));
+    const StackKey key = run_key(data, flags);
+    const bool unchanged = entry.key == key && entry.seen == index.version;
+    entry.seen = index.version;
+    if (!entry.valid || entry.key != key || count < entry.count || !appended_since(index, entry.version, 0)) {
+        entry.key = key;
+        entry.valid = unchanged;
+        entry.kept = false;
+        entry.first = entry.last = entry.count = 0;
+        entry.starts.resize(0);
+        if (!entry.valid)
+            return nullptr;
+    }
+    // the window spans one view width to each side of the view
+    const int margin = last - first;
+    const int window_first = ImMax(first - margin, 0);
+    const int window_last = last + ImMin(margin, count - last);
+    // a window reaching the end of the data follows its appends, up to the window of this view
+    const bool at_end = entry.last > entry.first && entry.last == entry.count;
+    const int reach = at_end ? ImMax(window_last, entry.last) : entry.last;
+    bool scanned = true;
+    if (first < entry.first || last > reach) {
+        entry.first = window_first;
+        entry.starts.resize(0);
+        run_scan(index, colorer, window_first, window_last, entry);
+    }
+    else if (at_end && (entry.version != index.version || entry.count != count)) {
+        // appending may have extended the last segment and changed its color, it is looked at again
+        const int from = entry.last - 1;
+        if (entry.starts.back() == from)
+            entry.starts.pop_back();
+        run_scan(index, colorer, from, reach, entry);
+    }
+    else {
+        scanned = false;
+    }
+    entry.version = index.version;
+    entry.count = count;
+    if (scanned)
+        entry.kept = (int64_t)entry.starts.Size * (entry.kept ? RUN_DROP_LENGTH : RUN_KEEP_LENGTH) <= entry.last - entry.first;
+    return entry.kept ? &entry : nullptr;
+}
+
+// The runs of a stack read as segments, run r covers segments [starts[r], starts[r + 1])
+template <typename Index>
+struct RunIndex {
+    RunIndex(const Index& index, const RunEntry& runs) : index(index), starts(runs.starts.Data), runs(runs.starts.Size), last(runs.last) { }
+    int run_last(int run) const { return (run + 1 < runs ? starts[run + 1] : last) - 1; }
+    double segment_min(int run) const { return ImMin(index.segment_min(starts[run]), index.segment_min(run_last(run))); }
+    double segment_max(int run) const { return ImMax(index.segment_max(starts[run]), index.segment_max(run_last(run))); }
+    // Maps the range [first, last) of segments to the range of the runs holding them
+    void find_runs(int first, int last, int* run_first, int* run_last) const {
+        *run_first = (int)(std::upper_bound(starts, starts + runs, first) - starts) - 1;
+        *run_last = (int)(std::lower_bound(starts, starts + runs, last) - starts);
+    }
+    const Index& index;
+    const int*   starts;
+    const int    runs;
+    const int    last;
+};
+
+template <typename Colorer>
+struct RunColorer {
+    RunColorer(const Colorer& colorer, const RunEntry& runs) : colorer(colorer), starts(runs.starts.Data) { }
+    template <typename I> ImU32 operator()(I idx) const {
+        return colorer(starts[idx]);
+    }
+    const Colorer& colorer;
+    const int*     starts;
+};
+
+// Calls func(index, colorer, first, last) with the runs overlapping segments [first, last) when id keeps runs for the stack,
+// else with the segments themselves
+template <typename Index, typename Colorer, typename Func>
+void with_runs(ImGuiID id, const Index& index, const Colorer& colorer, int count, int first, int last, ImPlotBarGroupsFlags flags, Func&& func) {
+    // the count passed for a compressed timeline is that of the whole timeline, only the decoded segments are in the index
+    const RunEntry* runs = update_runs(id, index, colorer, ImMin(count, index.count()), first, last, flags);
+    if (runs == nullptr) {
+        func(index, colorer, first, last);
+        return;
+    }
+    const RunIndex<Index> run_index(index, *runs);
+    int run_first, run_last;
+    run_index.find_runs(first, last, &run_first, &run_last);
+    func(run_index, RunColorer<Colorer>(colorer, *runs), run_first, run_last);
+}
+
+
+//-----------------------------------------------------------------------------
+// [SECTION] New function for Ploting continous bar stack
+//-----------------------------------------------------------------------------
+
+// Scratch buffers for the X extents of the rendered slice, in plot and in pixel space
+struct PixelBuffers {
+    ImVector<double> x_min;
+    ImVector<double> x_max;
+    ImVector<float> px_min;
+    ImVector<float> px_max;
+};
+
+static PixelBuffers& get_pixel_buffers() {
+    static PixelBuffers buffers;
+    return buffers;
+}
+
+static const float PIXEL_CLIP_MARGIN = 64.0f; // pixels kept on each side of the plot when far off-screen bar ends are clamped
+
+// Pixel space bars are produced in: the screen, or pixels relative to the anchor of a followed stack
+struct PixelFrame {
+    float column_phase; // pixel columns of the level of detail start where px + column_phase is a whole number
+    float clip_min;     // bar ends are clamped to [clip_min, clip_max], far off-screen ones would overflow the int pixel columns
+    float clip_max;
+};
+
+static PixelFrame screen_frame(const ImPlotPlot& plot) {
+    PixelFrame frame;
+    frame.column_phase = 0.0f;
+    frame.clip_min = plot.PlotRect.Min.x - PIXEL_CLIP_MARGIN;
+    frame.clip_max = plot.PlotRect.Max.x + PIXEL_CLIP_MARGIN;
+    return frame;
+}
+
+// Converts the X extents of segments [0, count) of getter1/getter2 to pixels clamped to the frame, the results stay valid until the next call
+template <typename Getter1, typename Getter2>
+void stack_to_pixels(const Getter1& getter1, const Getter2& getter2, int count, const Transformer1& t_x, const PixelFrame& frame, float** px_min, float** px_max) {
+    PixelBuffers& pix = get_pixel_buffers();
+    pix.x_min.resize(count);
+    pix.x_max.resize(count);
+    pix.px_min.resize(count);
+    pix.px_max.resize(count);
+    for (int i = 0; i < count; ++i) {
+        pix.x_min.Data[i] = getter1(i).x;
+        pix.x_max.Data[i] = getter2(i).x;
+    }
+    transform_batch(t_x, pix.x_min.Data, pix.px_min.Data, count);
+    transform_batch(t_x, pix.x_max.Data, pix.px_max.Data, count);
+    for (int i = 0; i < count; ++i) {
+        pix.px_min.Data[i] = ImClamp(pix.px_min.Data[i], frame.clip_min, frame.clip_max);
+        pix.px_max.Data[i] = ImClamp(pix.px_max.Data[i], frame.clip_min, frame.clip_max);
+    }
+    *px_min = pix.px_min.Data;
+    *px_max = pix.px_max.Data;
+    if (t_x.m < 0)
+        ImSwap(*px_min, *px_max); // inverted axis
+}
+
+// Merges adjacent bars of the same color into one bar in place and returns the number of bars left,
+// so repeated samples of a state cost one quad per real transition
+static int coalesce_runs(float* px_min, float* px_max, ImU32* colors, int count) {
+    if (count == 0)
+        return 0;
+    int n = 0;
+    for (int i = 1; i < count; ++i) {
+        if (colors[i] == colors[n] && (px_min[i] == px_max[n] || px_max[i] == px_min[n])) {
+            px_min[n] = ImMin(px_min[n], px_min[i]);
+            px_max[n] = ImMax(px_max[n], px_max[i]);
+            continue;
+        }
+        ++n;
+        px_min[n] = px_min[i];
+        px_max[n] = px_max[i];
+        colors[n] = colors[i];
+    }
+    return n + 1;
+}
+
+// Runs are merged already, bars of any other index are merged in pixels
+template <typename Index>
+static int coalesce_bars(const Index&, float* px_min, float* px_max, ImU32* colors, int count) {
+    return coalesce_runs(px_min, px_max, colors, count);
+}
+
+template <typename Index>
+static int coalesce_bars(const RunIndex<Index>&, float*, float*, ImU32*, int count) {
+    return count;
+}
+
+// Vertical pixel span of a lane, every bar of the lane shares it
+static void lane_to_pixels(const Transformer1& t_y, double height, double shift, float* y_min, float* y_max) {
+    float y1 = t_y(shift + height / 2);
+    float y2 = t_y(shift - height / 2);
+    float height_px = ImAbs(y1 - y2);
+    if (height_px < 1.0f) {
+        y1 += y1 > y2 ? (1 - height_px) / 2 : (height_px - 1) / 2;
+        y2 += y2 > y1 ? (1 - height_px) / 2 : (height_px - 1) / 2;
+    }
+    *y_min = ImMin(y1, y2);
+    *y_max = ImMax(y1, y2);
+}
+
+// Renders segments [first, last) of a stack, collapsing sub-pixel segments unless BarStackFlags_NoLod is set
+template <typename Index, typename Colorer>
+void render_bar_stack(const Index& index, const Colorer& colorer, int first, int last, double height, double shift, ImPlotBarGroupsFlags flags) {
+    typedef GetterXY<IndexerStackMin<Index>, IndexerConst> GetterMin;
+    typedef GetterXY<IndexerStackMax<Index>, IndexerConst> GetterMax;
+    ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+    ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+    const ImRect& cull_rect = plot.PlotRect;
+    const int visible = last - first;
+    GetterMin getter1(IndexerStackMin<Index>(index, first, visible), IndexerConst(shift), visible);
+    GetterMax getter2(IndexerStackMax<Index>(index, first, visible), IndexerConst(shift), visible);
+    ImVector<ImU32>& color_buffer = get_color_buffer();
+    resolve_colors(colorer, first, visible, color_buffer);
+    ImU32* colors = color_buffer.Data;
+    float* px_min;
+    float* px_max;
+    stack_to_pixels(getter1, getter2, visible, Transformer1(plot.Axes[plot.CurrentX]), screen_frame(plot), &px_min, &px_max);
+    const int count = coalesce_bars(index, px_min, px_max, colors, visible);
+    float y_min, y_max;
+    lane_to_pixels(Transformer1(plot.Axes[plot.CurrentY]), height, shift, &y_min, &y_max);
+    if (!ImHasFlag(flags, BarStackFlags_NoLod)) {
+        LodBuffers& lod = get_lod_buffers();
+        const int lod_count = lod_aggregate(px_min, px_max, colors, count, 0.0f, flags, lod);
+        RenderPrimitivesEx(RendererBarStackPixH(lod.min.Data, lod.max.Data, lod.colors.Data, lod_count, &y_min, &y_max, 0), draw_list, cull_rect);
+    }
+    else {
+        RendererBarStackPixH renderer(px_min, px_max, colors, count, &y_min, &y_max, 0);
+        if (ImHasFlag(flags, BarStackFlags_Parallel))
+            RenderPrimitivesParallel(renderer, draw_list, cull_rect);
+        else
+            RenderPrimitivesEx(renderer, draw_list, cull_rect);
+    }
+}
+
+// Converts segments [first, last) of a stack to bars in the pixels of frame, merges equal runs and aggregates sub-pixel bars
+// unless BarStackFlags_NoLod is set, then passes the bars to emit(px_min, px_max, colors, count)
+template <typename Index, typename Colorer, typename Emit>
+void collect_range(const Index& index, const Colorer& colorer, int first, int last, const Transformer1& t_x, const PixelFrame& frame, ImPlotBarGroupsFlags flags, const Emit& emit) {
+    typedef GetterXY<IndexerStackMin<Index>, IndexerConst> GetterMin;
+    typedef GetterXY<IndexerStackMax<Index>, IndexerConst> GetterMax;
+    if (first >= last)
+        return;
+    const int visible = last - first;
+    GetterMin getter1(IndexerStackMin<Index>(index, first, visible), IndexerConst(0), visible);
+    GetterMax getter2(IndexerStackMax<Index>(index, first, visible), IndexerConst(0), visible);
+    ImVector<ImU32>& colors = get_color_buffer();
+    resolve_colors(colorer, first, visible, colors);
+    float* px_min;
+    float* px_max;
+    stack_to_pixels(getter1, getter2, visible, t_x, frame, &px_min, &px_max);
+    const int runs = coalesce_bars(index, px_min, px_max, colors.Data, visible);
+    if (!ImHasFlag(flags, BarStackFlags_NoLod)) {
+        LodBuffers& lod = get_lod_buffers();
+        const int lod_count = lod_aggregate(px_min, px_max, colors.Data, runs, frame.column_phase, flags, lod);
+        emit(lod.min.Data, lod.max.Data, lod.colors.Data, lod_count);
+    }
+    else {
+        emit(px_min, px_max, colors.Data, runs);
+    }
+}
+
+// Same as above for the segments inside the visible X range, read through the runs kept for id
+template <typename Index, typename Colorer, typename Emit>
+void collect_bars(ImGuiID id, const Index& index, const Colorer& colorer, int count, const Transformer1& t_x, ImPlotBarGroupsFlags flags, const Emit& emit) {
+    ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+    const ImPlotAxis& x_axis = plot.Axes[plot.CurrentX];
+    int first, last;
+    index.find_visible(x_axis.Range.Min, x_axis.Range.Max, &first, &last);
+    last = ImMin(last, count);
+    if (first >= last)
+        return;
+    stats_visible(last - first);
+    with_runs(id, index, colorer, count, first, last, flags, [&](const auto& runs, const auto& run_colorer, int run_first, int run_last) {
+        collect_range(runs, run_colorer, run_first, run_last, t_x, screen_frame(plot), flags, emit);
+    });
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Strips
+//-----------------------------------------------------------------------------
+// With BarStackFlags_Strip, a lane is rasterised on the CPU into one row of RGBA pixels at plot resolution.
+// All rows live in one atlas texture, and each lane is drawn as a single textured quad sampling its row.
+// On a linear X axis a row spans the whole atlas width around the view, from a plot X called its anchor, and is keyed on
+// the data and the zoom only: panning moves the texture coordinates of the quad, the row is rasterised again when the
+// data or the zoom change or the view leaves it. Other axes key the row on the whole axis and rasterise the view only.
+
+static const int STRIP_ATLAS_WIDTH    = 4096;
+static const int STRIP_ATLAS_MAX_ROWS = 4096;
+static const int STRIP_ROW_IDLE_FRAMES = 120; // frames without a draw after which a row of a full atlas is handed to another lane
+
+static BarStackTextureBackend texture_backend;
+
+void set_bar_stack_texture_backend(const BarStackTextureBackend& backend) {
+    // textures replaced by a larger atlas are handed back through destroy, without it they would leak
+    IM_ASSERT(backend.create == nullptr || (backend.update != nullptr && backend.destroy != nullptr));
+    texture_backend = backend;
+}
+
+void rasterize_bar_stack_strip(const float* px_min, const float* px_max, const ImU32* colors, int count, float x_origin, int width, ImU32* row) {
+    for (int i = 0; i < count; ++i) {
+        // a column is covered when its center is, a bar too thin to cover any center still covers the column it starts in
+        const float x_min = px_min[i] - x_origin;
+        const float x_max = px_max[i] - x_origin;
+        int c0 = (int)std::ceil(x_min - 0.5f);
+        int c1 = (int)std::ceil(x_max - 0.5f);
+        if (c1 <= c0) {
+            c0 = (int)std::floor(x_min);
+            c1 = c0 + 1;
+        }
+        c0 = ImMax(c0, 0);
+        c1 = ImMin(c1, width);
+        for (int c = c0; c < c1; ++c)
+            row[c] = colors[i];
+    }
+}
+
+struct StripSlot {
+    ImGuiID  id;
+    StackKey key;
+    double   anchor;     // plot X of the first pixel of the row
+    int      last_frame; // frame the row was last drawn in
+    bool     used;       // owned by id, else free
+    bool     valid;      // rasterised for key
+};
+
+// Slot i owns row i of the atlas. Once every row has been handed out, the rows of lanes not drawn for
+// STRIP_ROW_IDLE_FRAMES are released for new lanes.
+struct StripAtlas {
+    StripAtlas() : texture(), rows(0), retired_frame(-1), release_frame(-1) { }
+    ImTextureID           texture;
+    int                   rows;
+    ImVector<ImU32>       pixels;   // STRIP_ATLAS_WIDTH * rows
+    ImVector<StripSlot>   slots;
+    ImGuiStorage          slot_by_id;
+    ImVector<int>         free_rows;
+    ImVector<ImTextureID> retired;  // textures replaced by a larger atlas, still drawn by the frame they were replaced in
+    int                   retired_frame;
+    int                   release_frame; // frame of the last look for idle rows, done at most once per frame
+};
+
+static StripAtlas& get_strip_atlas() {
+    static StripAtlas atlas;
+    return atlas;
+}
+
+// Destroys the textures retired in an earlier frame, whose draw data has been rendered by now
+static void strip_release_retired(StripAtlas& atlas) {
+    if (atlas.retired.empty() || atlas.retired_frame == ImGui::GetFrameCount())
+        return;
+    for (ImTextureID texture : atlas.retired)
+        texture_backend.destroy(texture);
+    atlas.retired.resize(0);
+}
+
+// Frees the rows of lanes that were not drawn for STRIP_ROW_IDLE_FRAMES
+static void strip_release_idle(StripAtlas& atlas) {
+    const int frame = ImGui::GetFrameCount();
+    if (atlas.release_frame == frame)
+        return;
+    atlas.release_frame = frame;
+    for (int row = 0; row < atlas.slots.Size; ++row) {
+        StripSlot& slot = atlas.slots[row];
+        if (!slot.used || frame - slot.last_frame <= STRIP_ROW_IDLE_FRAMES)
+            continue;
+        atlas.slot_by_id.SetInt(slot.id, -1);
+        slot.used = false;
+        slot.valid = false;
+        atlas.free_rows.push_back(row);
+    }
+}
+
+static bool strip_available(int width) {
+    return texture_backend.create != nullptr && texture_backend.update != nullptr && texture_backend.destroy != nullptr &&
+        width > 0 && width <= STRIP_ATLAS_WIDTH;
+}
+
+// True when the row can be panned over, its pixels then only depend on the zoom
+static bool strip_linear(const ImPlotAxis& x_axis) {
+    return x_axis.TransformForward == nullptr && x_axis.ScaleToPixel > 0;
+}
+
+// A strip row only depends on the X direction, and on a linear axis only on its zoom
+static StackKey strip_key(const void* data, uint64_t version, int count, const ImPlotAxis& x_axis, const ImRect& plot_rect, ImPlotBarGroupsFlags flags) {
+    StackKey key;
+    key.data = data;
+    key.version = version;
+    key.count = count;
+    key.flags = flags;
+    key.palette = active_palette;
+    if (strip_linear(x_axis)) {
+        key.x.scale = x_axis.ScaleToPixel;
+        return key;
+    }
+    key.x.set(x_axis);
+    key.plot_rect.Min.x = plot_rect.Min.x;
+    key.plot_rect.Max.x = plot_rect.Max.x;
+    return key;
+}
+
+// Returns the atlas row of id, rasterised again by raster(row) from anchor when key changed or covers(slot anchor) is false,
+// or -1 when the atlas is full
+template <typename Covers, typename Raster>
+int strip_row(ImGuiID id, const StackKey& key, double anchor, const Covers& covers, const Raster& raster) {
+    StripAtlas& atlas = get_strip_atlas();
+    strip_release_retired(atlas);
+    const int frame = ImGui::GetFrameCount();
+    int row = atlas.slot_by_id.GetInt(id, -1);
+    if (row < 0) {
+        if (atlas.free_rows.empty() && atlas.slots.Size == STRIP_ATLAS_MAX_ROWS)
+            strip_release_idle(atlas);
+        const StripSlot slot = { id, StackKey(), 0.0, frame, true, false };
+        if (!atlas.free_rows.empty()) {
+            row = atlas.free_rows.back();
+            atlas.free_rows.pop_back();
+            atlas.slots[row] = slot;
+        }
+        else if (atlas.slots.Size < STRIP_ATLAS_MAX_ROWS) {
+            row = atlas.slots.Size;
+            atlas.slots.push_back(slot);
+        }
+        else {
+            return -1;
+        }
+        atlas.slot_by_id.SetInt(id, row);
+    }
+    atlas.slots[row].last_frame = frame;
+    if (row >= atlas.rows) {
+        // grow the atlas, the texture is created again with the rows rasterised so far.
+        // Lanes drawn earlier in this frame still sample the old texture with the old row count, it is destroyed in a later frame.
+        const int rows = ImMin(ImMax(atlas.rows * 2, 16), STRIP_ATLAS_MAX_ROWS);
+        atlas.pixels.resize(STRIP_ATLAS_WIDTH * rows);
+        memset(atlas.pixels.Data + STRIP_ATLAS_WIDTH * atlas.rows, 0, (size_t)STRIP_ATLAS_WIDTH * (rows - atlas.rows) * sizeof(ImU32));
+        if (atlas.texture != ImTextureID()) {
+            atlas.retired.push_back(atlas.texture);
+            atlas.retired_frame = ImGui::GetFrameCount();
+        }
+        atlas.rows = rows;
+        atlas.texture = texture_backend.create(STRIP_ATLAS_WIDTH, atlas.rows, atlas.pixels.Data);
+    }
+    StripSlot& slot = atlas.slots[row];
+    if (!slot.valid || slot.key != key || !covers(slot.anchor)) {
+        ImU32* pixels = atlas.pixels.Data + STRIP_ATLAS_WIDTH * row;
+        memset(pixels, 0, STRIP_ATLAS_WIDTH * sizeof(ImU32));
+        raster(pixels);
+        texture_backend.update(atlas.texture, row, STRIP_ATLAS_WIDTH, 1, pixels);
+        slot.key = key;
+        slot.anchor = anchor;
+        slot.valid = true;
+    }
+    return row;
+}
+
+// Draws row of the atlas as one quad of width pixels starting at x_min, sampling the row from pixel u_px on
+static void strip_draw(ImDrawList& draw_list, int row, float x_min, int width, float u_px, float y_min, float y_max) {
+    const StripAtlas& atlas = get_strip_atlas();
+    const float v = (row + 0.5f) / atlas.rows;
+    draw_list.AddImage(atlas.texture, ImVec2(x_min, y_min), ImVec2(x_min + width, y_max),
+        ImVec2(u_px / STRIP_ATLAS_WIDTH, v), ImVec2((u_px + width) / STRIP_ATLAS_WIDTH, v));
+}
+
+// Rasterises the segments of a stack around the view into its strip and draws it, returns false when the stack has to be
+// rendered as quads
+template <typename Index, typename Colorer>
+bool plot_strip(ImGuiID id, const Index& index, const Colorer& colorer, int count, float y_min, float y_max, ImPlotBarGroupsFlags flags) {
+    ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+    const ImRect& plot_rect = plot.PlotRect;
+    const int width = (int)std::ceil(plot_rect.GetWidth());
+    if (!strip_available(width))
+        return false;
+    const ImPlotAxis& x_axis = plot.Axes[plot.CurrentX];
+    const StackKey key = strip_key(&index, index.version, count, x_axis, plot_rect, flags);
+    if (!strip_linear(x_axis)) {
+        const int row = strip_row(id, key, 0.0, [](double) { return true; }, [&](ImU32* pixels) {
+            collect_bars(id, index, colorer, count, Transformer1(x_axis), flags, [&](const float* px_min, const float* px_max, const ImU32* colors, int n) {
+                rasterize_bar_stack_strip(px_min, px_max, colors, n, plot_rect.Min.x, width, pixels);
+            });
+        });
+        if (row < 0)
+            return false;
+        strip_draw(*ImPlot::GetPlotDrawList(), row, plot_rect.Min.x, width, 0.0f, y_min, y_max);
+        return true;
+    }
+    // a new row leaves the same margin on both sides of the view, a whole number of pixels so its columns match the screen
+    const double m = x_axis.ScaleToPixel;
+    const double margin = (double)((STRIP_ATLAS_WIDTH - width) / 2);
+    const double anchor = x_axis.Range.Min + (plot_rect.Min.x - margin - x_axis.PixelMin) / m;
+    // pixel of the row under the left edge of the plot
+    auto row_px = [&](double row_anchor) { return plot_rect.Min.x - (x_axis.PixelMin + (row_anchor - x_axis.Range.Min) * m); };
+    const int row = strip_row(id, key, anchor, [&](double row_anchor) {
+        const double px = row_px(row_anchor);
+        return px >= 0 && px + width <= STRIP_ATLAS_WIDTH;
+    }, [&](ImU32* pixels) {
+        int first, last;
+        index.find_visible(anchor, anchor + STRIP_ATLAS_WIDTH / m, &first, &last);
+        last = ImMin(last, count);
+        if (first >= last)
+            return;
+        stats_visible(last - first);
+        const Transformer1 t_rel(0.0, anchor, anchor, m, 0.0, 0.0, nullptr, nullptr);
+        PixelFrame frame;
+        frame.column_phase = 0.0f;
+        frame.clip_min = -PIXEL_CLIP_MARGIN;
+        frame.clip_max = STRIP_ATLAS_WIDTH + PIXEL_CLIP_MARGIN;
+        with_runs(id, index, colorer, count, first, last, flags, [&](const auto& runs, const auto& run_colorer, int run_first, int run_last) {
+            collect_range(runs, run_colorer, run_first, run_last, t_rel, frame, flags, [&](const float* px_min, const float* px_max, const ImU32* colors, int n) {
+                rasterize_bar_stack_strip(px_min, px_max, colors, n, 0.0f, STRIP_ATLAS_WIDTH, pixels);
+            });
+        });
+    });
+    if (row < 0)
+        return false;
+    strip_draw(*ImPlot::GetPlotDrawList(), row, plot_rect.Min.x, width, (float)row_px(get_strip_atlas().slots[row].anchor), y_min, y_max);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Vertex Cache
+//-----------------------------------------------------------------------------
+// A static plot regenerates the same vertices every frame. Each stack keeps the output of its last frame, and when its key
+// did not change the output is replayed with one bulk copy of the vertices and a rebase of the indices.
+// Outputs spanning a draw command split are not kept, they are regenerated. The output is only kept once the same key
+// comes back on two calls in a row: a panning view, or data rebuilt on every call like the index of raw lengths or the
+// timestamps read in place, would copy its output every frame and never replay it. Very large outputs are not kept either.
+
+static const int VERTEX_CACHE_MAX_VERTICES = 1 << 18; // 5 MB of vertices per stack, a larger output is regenerated
+
+struct VertexCacheEntry {
+    VertexCacheEntry() : valid(false) { }
+    StackKey               key; // key of the last call
+    bool                   valid;
+    ImVector<ImDrawVert>   vtx;
+    ImVector<unsigned int> idx; // relative to the first vertex of the output
+};
+
+static StackKey vertex_key(const void* data, uint64_t version, int count, const ImPlotPlot& plot, ImDrawList& draw_list, double height, double shift, ImPlotBarGroupsFlags flags) {
+    StackKey key;
+    key.data = data;
+    key.version = version;
+    key.count = count;
+    key.flags = flags;
+    key.palette = active_palette;
+    key.x.set(plot.Axes[plot.CurrentX]);
+    key.y.set(plot.Axes[plot.CurrentY]);
+    key.plot_rect = plot.PlotRect;
+    key.height = height;
+    key.shift = shift;
+    key.uv = draw_list._Data->TexUvWhitePixel;
+    return key;
+}
+
+// Position of the draw list before a stack is rendered
+struct VertexCapture {
+    VertexCapture(const ImDrawList& draw_list) :
+        vtx_offset(draw_list.VtxBuffer.Size),
+        idx_offset(draw_list.IdxBuffer.Size),
+        cmd_count(draw_list.CmdBuffer.Size),
+        vtx_idx(draw_list._VtxCurrentIdx)
+    { }
+    const int          vtx_offset;
+    const int          idx_offset;
+    const int          cmd_count;
+    const unsigned int vtx_idx;
+};
+
+// Keeps what was rendered since capture, unless it was split over several draw commands or the key changed since the last call
+static void vertex_cache_store(const ImDrawList& draw_list, const VertexCapture& capture, const StackKey& key, VertexCacheEntry& entry) {
+    const int vtx_count = draw_list.VtxBuffer.Size - capture.vtx_offset;
+    const int idx_count = draw_list.IdxBuffer.Size - capture.idx_offset;
+    const bool repeated = entry.key == key;
+    entry.key = key;
+    entry.valid = repeated && vtx_count <= VERTEX_CACHE_MAX_VERTICES &&
+        draw_list.CmdBuffer.Size == capture.cmd_count && draw_list._VtxCurrentIdx - capture.vtx_idx == (unsigned int)vtx_count;
+    if (!entry.valid) {
+        entry.vtx.clear();
+        entry.idx.clear();
+        return;
+    }
+    entry.vtx.resize(vtx_count);
+    memcpy(entry.vtx.Data, draw_list.VtxBuffer.Data + capture.vtx_offset, vtx_count * sizeof(ImDrawVert));
+    entry.idx.resize(idx_count);
+    for (int i = 0; i < idx_count; ++i)
+        entry.idx.Data[i] = draw_list.IdxBuffer.Data[capture.idx_offset + i] - capture.vtx_idx;
+}
+
+// Replays the output kept for key, returns false when it has to be generated
+static bool vertex_cache_replay(ImDrawList& draw_list, const VertexCacheEntry& entry, const StackKey& key) {
+    if (!entry.valid || entry.key != key || draw_list._VtxCurrentIdx + entry.vtx.Size > MaxIdx<ImDrawIdx>::value)
+        return false;
+    prim_reserve(draw_list, entry.idx.Size, entry.vtx.Size);
+    memcpy(draw_list._VtxWritePtr, entry.vtx.Data, entry.vtx.Size * sizeof(ImDrawVert));
+    const unsigned int vtx_idx = draw_list._VtxCurrentIdx;
+    for (int i = 0; i < entry.idx.Size; ++i)
+        draw_list._IdxWritePtr[i] = (ImDrawIdx)(entry.idx.Data[i] + vtx_idx);
+    draw_list._VtxWritePtr += entry.vtx.Size;
+    draw_list._IdxWritePtr += entry.idx.Size;
+    draw_list._VtxCurrentIdx += entry.vtx.Size;
+    stats_replay(entry.vtx.Size);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Follow
+//-----------------------------------------------------------------------------
+// With BarStackFlags_Follow a stack keeps the bars of its finalised segments across frames, in pixels relative to an anchor
+// on the X axis. Each frame only the segments appended since the last frame and the segments starting in the pixel column
+// of the last segment are converted, and when the view scrolls the kept bars are moved by the pixel offset of the anchor.
+// The column of the last segment stays open, so a level of detail bucket never spans two batches and the last segment may
+// still grow. The buckets are aligned to the pixel columns of the screen through the sub-pixel phase of the anchor, so they
+// only stay valid while the view scrolls by whole pixels. A run of one color reaching into the open column is kept as one bar
+// up to that column once it is a pixel wide, which the plain path draws on its own too, and that bar grows with the run.
+
+static const double FOLLOW_MAX_OFFSET = 65536.0; // pixels the anchor may scroll away before the kept bars are rebuilt, float keeps sub-pixel precision up to there
+static const double FOLLOW_MAX_PHASE_SHIFT = 1e-3; // pixels the columns may move by before the aggregated kept bars are rebuilt
+
+struct FollowEntry {
+    FollowEntry() : version(0), anchor(0), phase(0), covered_min(0), finalized(0), scanned(0), tail_run(0), extendable(false) { }
+    StackKey        key;
+    uint64_t        version;     // version of the data the kept bars were converted from
+    double          anchor;      // plot X of relative pixel 0
+    double          phase;       // position of the anchor inside its screen pixel column, in [0, 1)
+    double          covered_min; // the kept bars cover the view from here on, bars left of it were dropped
+    int             finalized;   // segments before it are in the kept bars, or were left of the view
+    int             scanned;     // segments whose colors were compared for tail_run
+    int             tail_run;    // the segments from here to the last one have one color
+    bool            extendable;  // the last kept bar is a run of one color continuing at finalized
+    ImVector<float> px_min;        // kept bars, relative to the anchor
+    ImVector<float> px_max;
+    ImVector<ImU32> colors;
+};
+
+// Bars drawn this frame in screen pixels: the visible kept bars followed by the bars of the open column
+struct FollowBuffers {
+    ImVector<float> px_min;
+    ImVector<float> px_max;
+    ImVector<ImU32> colors;
+};
+
+static FollowBuffers& get_follow_buffers() {
+    static FollowBuffers buffers;
+    return buffers;
+}
+
+static StackKey follow_key(const void* data, const ImPlotAxis& x_axis, ImPlotBarGroupsFlags flags) {
+    StackKey key;
+    key.data = data;
+    key.flags = flags;
+    key.palette = active_palette;
+    key.x.scale = x_axis.ScaleToPixel;
+    return key;
+}
+
+// Appends bars moved by offset pixels
+static void follow_append(const float* px_min, const float* px_max, const ImU32* colors, int count, float offset, ImVector<float>& out_min, ImVector<float>& out_max, ImVector<ImU32>& out_colors) {
+    for (int i = 0; i < count; ++i) {
+        out_min.push_back(px_min[i] + offset);
+        out_max.push_back(px_max[i] + offset);
+        out_colors.push_back(colors[i]);
+    }
+}
+
+// Collects the visible bars of a stack into get_follow_buffers(), reusing the bars kept for id.
+// Returns false when the X axis is not linear and increasing, the stack has to be collected from scratch then.
+template <typename Index, typename Colorer>
+bool follow_bars(ImGuiID id, const Index& index, const Colorer& colorer, int count, ImPlotBarGroupsFlags flags) {
+    ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+    const ImPlotAxis& x_axis = plot.Axes[plot.CurrentX];
+    const double m = x_axis.ScaleToPixel;
+    if (x_axis.TransformForward != nullptr || !(m > 0))
+        return false;
+    FollowEntry& entry = get_item_entry<FollowEntry>(id);
+    int first, last;
+    index.find_visible(x_axis.Range.Min, x_axis.Range.Max, &first, &last);
+    last = ImMin(last, count);
+    const StackKey key = follow_key(&index, x_axis, flags);
+    const bool appended = entry.finalized <= count && appended_since(index, entry.version, 0);
+    // screen pixel of the anchor, the kept level of detail buckets need it to stay in the same place inside its pixel column
+    double anchor_px = x_axis.PixelMin + (entry.anchor - x_axis.Range.Min) * m;
+    double phase_shift = anchor_px - std::floor(anchor_px) - entry.phase;
+    phase_shift -= std::floor(phase_shift + 0.5);
+    const bool aligned = ImHasFlag(flags, BarStackFlags_NoLod) || ImAbs(phase_shift) <= FOLLOW_MAX_PHASE_SHIFT;
+    if (entry.key != key || !appended || !aligned || entry.finalized < first || x_axis.Range.Min < entry.covered_min ||
+        ImAbs(anchor_px - x_axis.PixelMin) > FOLLOW_MAX_OFFSET) {
+        // start over from the visible range
+        entry.key = key;
+        entry.anchor = x_axis.Range.Min;
+        anchor_px = x_axis.PixelMin;
+        entry.phase = anchor_px - std::floor(anchor_px);
+        entry.covered_min = first > 0 ? index.segment_min(first) : -HUGE_VAL;
+        entry.finalized = first;
+        entry.scanned = first;
+        entry.tail_run = first;
+        entry.extendable = false;
+        entry.px_min.resize(0);
+        entry.px_max.resize(0);
+        entry.colors.resize(0);
+    }
+    entry.version = index.version;
+    const Transformer1 t_rel(0.0, entry.anchor, entry.anchor, m, 0.0, 0.0, nullptr, nullptr);
+    const float offset = (float)anchor_px;
+    // the view starts at most FOLLOW_MAX_OFFSET pixels away from the anchor, the kept bars are never shown outside of that
+    PixelFrame frame;
+    frame.column_phase = (float)entry.phase;
+    frame.clip_min = (float)(-FOLLOW_MAX_OFFSET) - PIXEL_CLIP_MARGIN;
+    frame.clip_max = (float)FOLLOW_MAX_OFFSET + plot.PlotRect.GetWidth() + PIXEL_CLIP_MARGIN;
+    // first segment starting in the pixel column of segment idx
+    auto column_first = [&](int idx) {
+        const double column_x = entry.anchor + (std::floor((index.segment_min(idx) - entry.anchor) * m + entry.phase) - entry.phase) / m;
+        int first_in, last_in;
+        index.find_visible(column_x, column_x, &first_in, &last_in);
+        while (first_in < idx && index.segment_min(first_in) < column_x)
+            ++first_in;
+        return first_in;
+    };
+    // appended segments only move the start of the trailing run of one color
+    for (int i = ImMax(entry.scanned, entry.tail_run + 1); i < count; ++i) {
+        if (colorer(i) != colorer(i - 1))
+            entry.tail_run = i;
+    }
+    entry.scanned = count;
+    // the last kept bar takes the segments continuing its run, up to the last one which may still grow
+    if (entry.extendable) {
+        int end = entry.finalized;
+        while (end < count - 1 && colorer(end) == colorer(entry.finalized - 1))
+            end = end >= entry.tail_run ? count - 1 : end + 1;
+        if (end > entry.finalized) {
+            entry.px_max.back() = ImClamp(t_rel(index.segment_min(end)), frame.clip_min, frame.clip_max);
+            entry.finalized = end;
+        }
+        entry.extendable = end == count - 1;
+    }
+    // The segments from the pixel column of the last one, or of the first one right of the view, stay open. So does the run
+    // of equal colors reaching into that column and the column it starts in, the plain path would merge them and put them
+    // into one bucket. The kept bars then end where the plain path ends a run and a bucket.
+    int open = last;
+    bool tail_kept = false;
+    if (count > 0) {
+        open = ImMin(last, count - 1);
+        const int column = ImMax(column_first(open), entry.finalized);
+        const int run_min = ImMax(entry.tail_run, entry.finalized);
+        if (open == count - 1 && run_min < column &&
+            (ImHasFlag(flags, BarStackFlags_NoLod) || t_rel(index.segment_min(column)) - t_rel(index.segment_min(run_min)) >= 1.0f)) {
+            // the trailing run is a pixel wide before the open column, the plain path draws it on its own and it is kept up to there
+            open = column;
+            tail_kept = true;
+        }
+        else {
+            for (;;) {
+                int run = ImMax(column_first(open), entry.finalized);
+                // the trailing run has one color, its start is known
+                if (run > run_min)
+                    run = run_min;
+                while (run > entry.finalized && colorer(run - 1) == colorer(run))
+                    --run;
+                if (run == open)
+                    break;
+                open = run;
+            }
+            open = ImMax(open, entry.finalized);
+        }
+    }
+    stats_visible(last - entry.finalized);
+    if (open > entry.finalized) {
+        collect_range(index, colorer, entry.finalized, open, t_rel, frame, flags, [&](const float* px_min, const float* px_max, const ImU32* colors, int n) {
+            follow_append(px_min, px_max, colors, n, 0.0f, entry.px_min, entry.px_max, entry.colors);
+        });
+        entry.finalized = open;
+        entry.extendable = tail_kept;
+    }
+    // kept bars left of the view are skipped, and dropped once they make up half of the kept bars
+    const float view_min = (float)((x_axis.Range.Min - entry.anchor) * m);
+    int hidden = (int)(std::lower_bound(entry.px_max.begin(), entry.px_max.end(), view_min) - entry.px_max.begin());
+    if (hidden > 0 && hidden * 2 >= entry.px_max.Size) {
+        entry.covered_min = entry.anchor + entry.px_max[hidden - 1] / m;
+        entry.px_min.erase(entry.px_min.begin(), entry.px_min.begin() + hidden);
+        entry.px_max.erase(entry.px_max.begin(), entry.px_max.begin() + hidden);
+        entry.colors.erase(entry.colors.begin(), entry.colors.begin() + hidden);
+        entry.extendable = entry.extendable && entry.px_max.Size > 0;
+        hidden = 0;
+    }
+    FollowBuffers& buffers = get_follow_buffers();
+    buffers.px_min.resize(0);
+    buffers.px_max.resize(0);
+    buffers.colors.resize(0);
+    follow_append(entry.px_min.Data + hidden, entry.px_max.Data + hidden, entry.colors.Data + hidden, entry.px_min.Size - hidden, offset, buffers.px_min, buffers.px_max, buffers.colors);
+    collect_range(index, colorer, open, last, t_rel, frame, flags, [&](const float* px_min, const float* px_max, const ImU32* colors, int n) {
+        follow_append(px_min, px_max, colors, n, offset, buffers.px_min, buffers.px_max, buffers.colors);
+    });
+    return true;
+}
+
+// Offsets of raw lengths plotted with BarStackFlags_Follow, kept per item and extended with the lengths appended since the last call.
+// Raw arrays have no version, so they are taken as append only: a grown count is the append, only the new lengths are read.
+// A smaller count, other arrays, or a first or last known length or state that changed rebuilds the offsets. That catches a
+// buffer refilled in place, like a std::vector cleared and filled again, edits between its ends are not seen.
+struct FollowIndex {
+    FollowIndex() : data(nullptr), values(nullptr), first_length(0), last_length(0), first_value(0), last_value(0) { }
+    BarStackIndex index;
+    const void*   data;   // lengths the index was built from
+    const void*   values; // states plotted with them
+    uint64_t      first_length; // bits of the first and last known length and state
+    uint64_t      last_length;
+    uint64_t      first_value;
+    uint64_t      last_value;
+};
+
+// Bits of a length or state, compared to tell an array refilled in place from an appended one
+template <typename T>
+static uint64_t follow_bits(T value) {
+    static_assert(sizeof(T) <= sizeof(uint64_t), "values are compared as one 64 bit word");
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(T));
+    return bits;
+}
+
+// value_bits(i) returns the follow_bits of state i of values
+template <typename T1, typename ValueBits>
+const BarStackIndex& follow_index(const char* label_id, const T1* bar_length, const void* values, const ValueBits& value_bits, int count, int offset, int stride) {
+    FollowIndex& entry = get_item_entry<FollowIndex>(ImPlot::GetCurrentPlot()->Items.GetItemID(label_id));
+    BarStackIndex& index = entry.index;
+    const int known = index.count();
+    const BarStackIndexer<T1, BarStackLayout_Strided> length(bar_length, count, 0, stride);
+    // a circular buffer moves its oldest entry every call, it is rebuilt
+    const bool appended = offset == 0 && known <= count && entry.data == (const void*)bar_length && entry.values == values &&
+        (known == 0 || (entry.first_length == follow_bits(length(0)) && entry.last_length == follow_bits(length(known - 1)) &&
+                        entry.first_value == value_bits(0) && entry.last_value == value_bits(known - 1)));
+    if (appended) {
+        for (int i = known; i < count; ++i)
+            index.append(length(i));
+    }
+    else {
+        index.build(bar_length, count, offset, stride);
+    }
+    entry.data = offset != 0 ? nullptr : (const void*)bar_length;
+    entry.values = values;
+    if (offset == 0 && count > 0) {
+        entry.first_length = follow_bits(length(0));
+        entry.last_length = follow_bits(length(count - 1));
+        entry.first_value = value_bits(0);
+        entry.last_value = value_bits(count - 1);
+    }
+    return index;
+}
+
+// Copied and modified from PlotBarsHEx in implot_items.cpp
+// The whole stack is registered as a single item, and only the segments inside the visible X range are rendered
+template <typename Index, typename Colorer>
+void plot_bars_stack_ex(const char* label_id, const Index& index, const Colorer& colorer, int count, double height, double shift, ImPlotBarGroupsFlags flags) {
+    StatsScope stats(label_id, count);
+    if (ImPlot::BeginItemEx(label_id, FitterBarStackH<Index>(index, count, shift, height), 0, ImPlotCol_Fill)) {
+        if (count <= 0) {
+            end_item();
+            return;
+        }
+        ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+        if (ImHasFlag(flags, BarStackFlags_Strip)) {
+            float y_min, y_max;
+            lane_to_pixels(Transformer1(plot.Axes[plot.CurrentY]), height, shift, &y_min, &y_max);
+            if (plot_strip(ImPlot::GetCurrentItem()->ID, index, colorer, count, y_min, y_max, flags)) {
+                end_item();
+                return;
+            }
+        }
+        ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+        VertexCacheEntry& cached = get_item_entry<VertexCacheEntry>(ImPlot::GetCurrentItem()->ID);
+        const StackKey key = vertex_key(&index, index.version, count, plot, draw_list, height, shift, flags);
+        if (vertex_cache_replay(draw_list, cached, key)) {
+            end_item();
+            return;
+        }
+        const VertexCapture capture(draw_list);
+        if (ImHasFlag(flags, BarStackFlags_Follow) && follow_bars(ImPlot::GetCurrentItem()->ID, index, colorer, count, flags)) {
+            FollowBuffers& buffers = get_follow_buffers();
+            float y_min, y_max;
+            lane_to_pixels(Transformer1(plot.Axes[plot.CurrentY]), height, shift, &y_min, &y_max);
+            RendererBarStackPixH renderer(buffers.px_min.Data, buffers.px_max.Data, buffers.colors.Data, buffers.px_min.Size, &y_min, &y_max, 0);
+            if (ImHasFlag(flags, BarStackFlags_Parallel))
+                RenderPrimitivesParallel(renderer, draw_list, plot.PlotRect);
+            else
+                RenderPrimitivesEx(renderer, draw_list, plot.PlotRect);
+            vertex_cache_store(draw_list, capture, key, cached);
+            end_item();
+            return;
+        }
+        const ImPlotAxis& x_axis = plot.Axes[plot.CurrentX];
+        int first, last;
+        index.find_visible(x_axis.Range.Min, x_axis.Range.Max, &first, &last);
+        last = ImMin(last, count);
+        if (first < last) {
+            stats_visible(last - first);
+            with_runs(ImPlot::GetCurrentItem()->ID, index, colorer, count, first, last, flags, [&](const auto& runs, const auto& run_colorer, int run_first, int run_last) {
+                render_bar_stack(runs, run_colorer, run_first, run_last, height, shift, flags);
+            });
+        }
+        vertex_cache_store(draw_list, capture, key, cached);
+        end_item();
+    }
+}
+
+// Copied and modified from PlotBarGroups in implot_items.cpp
+template <typename T1, typename T2, typename std::enable_if<!std::is_enum<T2>::value, int>::type>
+void plot_bar_stack(const char* label_id, const T1* bar_length, const std::vector<T2>& bar_value, int item_count, double group_size, double shift, ImPlotBarGroupsFlags flags) {
+    const bool horz = ImHasFlag(flags, ImPlotBarGroupsFlags_Horizontal);
+    ImPlot::SetupLock();
+    if (horz) {
+        // without a persistent index the offsets have to be accumulated on every call, or extended with BarStackFlags_Follow
+        static BarStackIndex temp_index;
+        const int count = ImMin(item_count, (int)bar_value.size());
+        if (!ImHasFlag(flags, BarStackFlags_Follow))
+            temp_index.build(bar_length, item_count);
+        const auto value_bits = [&](int i) { return follow_bits((T2)bar_value[i]); };
+        const BarStackIndex& index = ImHasFlag(flags, BarStackFlags_Follow) ? follow_index(label_id, bar_length, &bar_value, value_bits, count, 0, sizeof(T1)) : temp_index;
+        with_palette<T2>(BarStackPalette(), flags, [&](const auto& palette) {
+            typedef typename std::decay<decltype(palette)>::type Palette;
+            plot_bars_stack_ex(label_id, index, ColorerValue<T2, Palette>(bar_value, palette), count, group_size, shift, flags);
+        });
+    }
+}
+
+template <typename T1, typename T2, typename std::enable_if<!std::is_enum<T2>::value, int>::type>
+void plot_bar_stack(const char* label_id, const T1* bar_length, const T2* bar_value, int count, double group_size, double shift, ImPlotBarGroupsFlags flags, int offset, int length_stride, int value_stride) {
+    const bool horz = ImHasFlag(flags, ImPlotBarGroupsFlags_Horizontal);
+    ImPlot::SetupLock();
+    if (horz) {
+        static BarStackIndex temp_index;
+        if (!ImHasFlag(flags, BarStackFlags_Follow))
+            temp_index.build(bar_length, count, offset, length_stride);
+        const BarStackIndexer<T2, BarStackLayout_Strided> value(bar_value, count, 0, value_stride);
+        const auto value_bits = [&](int i) { return follow_bits(value(i)); };
+        const BarStackIndex& index = ImHasFlag(flags, BarStackFlags_Follow) ? follow_index(label_id, bar_length, bar_value, value_bits, count, offset, length_stride) : temp_index;
+        with_palette<T2>(BarStackPalette(), flags, [&](const auto& palette) {
+            typedef typename std::decay<decltype(palette)>::type Palette;
+            with_bar_stack_layout<T2>(count, offset, value_stride, [&](auto layout) {
+                plot_bars_stack_ex(label_id, index, ColorerData<T2, Palette, decltype(layout)::value>(bar_value, count, offset, value_stride, palette), count, group_size, shift, flags);
+            });
+        });
+    }
+}
+
+template <typename T, typename std::enable_if<!std::is_enum<T>::value, int>::type>
+void plot_bar_stack(const char* label_id, const BarStackIndex& index, const std::vector<T>& bar_value, double group_size, double shift, ImPlotBarGroupsFlags flags) {
+    const bool horz = ImHasFlag(flags, ImPlotBarGroupsFlags_Horizontal);
+    ImPlot::SetupLock();
+    if (horz) {
+        with_palette<T>(BarStackPalette(), flags, [&](const auto& palette) {
+            typedef typename std::decay<decltype(palette)>::type Palette;
+            plot_bars_stack_ex(label_id, index, ColorerValue<T, Palette>(bar_value, palette), ImMin(index.count(), (int)bar_value.size()), group_size, shift, flags);
+        });
+    }
+}
+
+template <typename T>
+void plot_bar_stack(const char* label_id, const BarStackTimeline<T>& timeline, double group_size, double shift, ImPlotBarGroupsFlags flags) {
+    const bool horz = ImHasFlag(flags, ImPlotBarGroupsFlags_Horizontal);
+    ImPlot::SetupLock();
+    if (!horz)
+        return;
+    // the pyramid is colored with the palette of the timeline or the defaults of T, a next palette or categorical states of other colors
+    // are plotted from the segments
+    const bool pyramid_colors = next_palette.colors == nullptr && (timeline.palette.colors != nullptr || !ImHasFlag(flags, BarStackFlags_Categorical) || default_palette_is_categorical<T>());
+    if (timeline.pyramid.enabled() && pyramid_colors) {
+        // zoomed out far enough for a pyramid level to be at most a pixel per bin, plot the level instead of the segments
+        ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+        const ImPlotAxis& x_axis = plot.Axes[plot.CurrentX];
+        const int level = x_axis.TransformForward == nullptr ? timeline.pyramid.pick_level(ImAbs(x_axis.ScaleToPixel)) : -1;
+        if (level >= 0) {
+            // the pyramid is colored with the palette of the timeline when it is built
+            active_palette = BarStackPalette();
+            const BarStackPyramidLevel& pyramid_level = timeline.pyramid.levels[level];
+            plot_bars_stack_ex(label_id, pyramid_level, ColorerPyramid(pyramid_level, flags), pyramid_level.count(), group_size, shift, flags);
+            return;
+        }
+    }
+    with_palette<T>(timeline.palette, flags, [&](const auto& palette) {
+        typedef typename std::decay<decltype(palette)>::type Palette;
+        plot_bars_stack_ex(label_id, timeline, ColorerValue<T, Palette, ImVector<T>>(timeline.states, palette), timeline.count(), group_size, shift, flags);
+    });
+}
+
+template <typename T>
+void plot_bar_stack(const char* label_id, const BarStackTimelineView<T>& view, double group_size, double shift, ImPlotBarGroupsFlags flags) {
+    const bool horz = ImHasFlag(flags, ImPlotBarGroupsFlags_Horizontal);
+    ImPlot::SetupLock();
+    if (!horz)
+        return;
+    with_palette<T>(BarStackPalette(), flags, [&](const auto& palette) {
+        typedef typename std::decay<decltype(palette)>::type Palette;
+        plot_bars_stack_ex(label_id, view, ColorerData<T, Palette>(view.states, view.count(), 0, sizeof(T), palette), view.count(), group_size, shift, flags);
+    });
+}
+
+template <typename T>
+void plot_bar_stack(const char* label_id, const BarStackCompressedTimeline<T>& timeline, double group_size, double shift, ImPlotBarGroupsFlags flags) {
+    const bool horz = ImHasFlag(flags, ImPlotBarGroupsFlags_Horizontal);
+    ImPlot::SetupLock();
+    if (!horz)
+        return;
+    ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+    const ImPlotAxis& x_axis = plot.Axes[plot.CurrentX];
+    DecodedBlocks<T>& decoded = get_item_entry<DecodedBlocks<T>>(plot.Items.GetItemID(label_id));
+    decode_visible_blocks(timeline, x_axis.Range.Min, x_axis.Range.Max, decoded);
+    // the indices of the decoded segments move as the view scrolls, they can not be followed
+    flags &= ~BarStackFlags_Follow;
+    // the count of the whole timeline is passed for fitting and the stats, the visible segments never go past the decoded ones
+    with_palette<T>(BarStackPalette(), flags, [&](const auto& palette) {
+        typedef typename std::decay<decltype(palette)>::type Palette;
+        plot_bars_stack_ex(label_id, decoded, ColorerData<T, Palette>(decoded.states.Data, decoded.count(), 0, sizeof(T), palette), timeline.count(), group_size, shift, flags);
+    });
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Timestamps
+//-----------------------------------------------------------------------------
+// Absolute timestamps are plotted relative to a time origin kept per plot. The difference to the origin is taken in integer
+// arithmetic and only the result is converted to double, which stays exact below 2^53 time units. Converting nanosecond
+// epoch timestamps directly would round them to 256 ns before Transformer1 even sees them.
+
+static const uint64_t TIME_ORIGIN_MAX_DISTANCE = 1ull << 53; // time units a double keeps exact, a latched origin further from the data is latched again
+
+struct TimeOrigin {
+    TimeOrigin() : set(false), latched(false), value(0) { }
+    bool     set;
+    bool     latched; // taken from the first timestamp plotted instead of set_bar_stack_time_origin()
+    uint64_t value;
+};
+
+static TimeOrigin& get_time_origin() {
+    return get_item_entry<TimeOrigin>(ImPlot::GetCurrentPlot()->ID);
+}
+
+void set_bar_stack_time_origin(uint64_t origin) {
+    TimeOrigin& entry = get_time_origin();
+    entry.set = true;
+    entry.latched = false;
+    entry.value = origin;
+}
+
+uint64_t get_bar_stack_time_origin() {
+    return get_time_origin().value;
+}
+
+// Segment i spans [timestamps[i], timestamps[i + 1]), read in place and rebased on origin
+struct TimestampIndex {
+    TimestampIndex() : timestamps(nullptr), segments(0), origin(0), version(0), append_version(0), edit_version(0) { }
+    double relative(int idx) const { return (double)(int64_t)(timestamps[idx] - origin); }
+    int count() const { return segments; }
+    double segment_min(int idx) const { return relative(idx); }
+    double segment_max(int idx) const { return relative(idx + 1); }
+    double stack_min(int) const { return relative(0); }
+    double stack_max(int count) const { return relative(count); }
+    void find_visible(double x_min, double x_max, int* first, int* last) const {
+        // segment i is visible if timestamps[i + 1] >= x_min and timestamps[i] <= x_max, both are non-decreasing
+        const uint64_t base = origin;
+        auto before = [base](uint64_t timestamp, double x) { return (double)(int64_t)(timestamp - base) < x; };
+        auto after = [base](double x, uint64_t timestamp) { return x < (double)(int64_t)(timestamp - base); };
+        *first = (int)(std::lower_bound(timestamps + 1, timestamps + segments + 1, x_min, before) - (timestamps + 1));
+        *last = (int)(std::upper_bound(timestamps, timestamps + segments, x_max, after) - timestamps);
+    }
+
+    const uint64_t* timestamps;
+    int             segments;
+    uint64_t        origin;
+    uint64_t        version;        // same as in BarStackIndex
+    uint64_t        append_version; // same as in BarStackIndex
+    uint64_t        edit_version;
+};
+
+template <typename T, typename std::enable_if<!std::is_enum<T>::value, int>::type>
+void plot_bar_stack_timestamps(const char* label_id, const uint64_t* timestamps, const T* states, int count, double group_size, double shift, ImPlotBarGroupsFlags flags) {
+    const bool horz = ImHasFlag(flags, ImPlotBarGroupsFlags_Horizontal);
+    ImPlot::SetupLock();
+    if (!horz)
+        return;
+    ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+    TimeOrigin& origin = get_time_origin();
+    if (count > 0) {
+        // an origin taken from the data follows it when the data moves out of the exact range of a double
+        const uint64_t distance = timestamps[0] > origin.value ? timestamps[0] - origin.value : origin.value - timestamps[0];
+        if (!origin.set || (origin.latched && distance > TIME_ORIGIN_MAX_DISTANCE)) {
+            origin.set = true;
+            origin.latched = true;
+            origin.value = timestamps[0];
+        }
+    }
+    TimestampIndex& index = get_item_entry<TimestampIndex>(plot.Items.GetItemID(label_id));
+    const int segments = ImMax(count - 1, 0);
+    // With BarStackFlags_Follow the timestamps are taken as append only, like the raw lengths: more segments of the same
+    // array on the same origin are an append, the same count is no change, anything else an edit. Without it they are read
+    // in place and may have changed since the last call.
+    const bool same = index.timestamps == timestamps && index.origin == origin.value;
+    if (!ImHasFlag(flags, BarStackFlags_Follow) || !same || segments < index.segments) {
+        index.version = next_version(index.version);
+    }
+    else if (segments > index.segments) {
+        if (index.version != index.append_version)
+            index.edit_version = index.version;
+        index.version = next_version(index.version);
+        index.append_version = index.version;
+    }
+    index.timestamps = timestamps;
+    index.segments = segments;
+    index.origin = origin.value;
+    with_palette<T>(BarStackPalette(), flags, [&](const auto& palette) {
+        typedef typename std::decay<decltype(palette)>::type Palette;
+        plot_bars_stack_ex(label_id, index, ColorerData<T, Palette>(states, index.segments, 0, sizeof(T), palette), index.segments, group_size, shift, flags);
+    });
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Lanes
+//-----------------------------------------------------------------------------
+// Many timelines plotted as one item: lanes outside the visible Y range are skipped before their data is read,
+// and the bars of all visible lanes are collected and rendered with a single reservation.
+
+// Same as FitterBarStackH over all lanes, the cost grows with the number of lanes but not with their segments
+template <typename T>
+struct FitterBarStackLanesH {
+    FitterBarStackLanesH(const BarStackTimeline<T>* const* lanes, int lane_count, double height, double spacing, double shift) :
+        lanes(lanes),
+        lane_count(lane_count),
+        half_height(height * 0.5),
+        spacing(spacing),
+        shift(shift)
+    { }
+    void Fit(ImPlotAxis& x_axis, ImPlotAxis& y_axis) const {
+        double x_min = HUGE_VAL;
+        double x_max = -HUGE_VAL;
+        for (int i = 0; i < lane_count; ++i) {
+            if (lanes[i]->count() == 0)
+                continue;
+            x_min = ImMin(x_min, lanes[i]->stack_min(lanes[i]->count()));
+            x_max = ImMax(x_max, lanes[i]->stack_max(lanes[i]->count()));
+        }
+        if (x_min > x_max)
+            return;
+        const double y_first = shift;
+        const double y_last = shift + (lane_count - 1) * spacing;
+        const double y_min = ImMin(y_first, y_last) - half_height;
+        const double y_max = ImMax(y_first, y_last) + half_height;
+        x_axis.ExtendFitWith(y_axis, x_min, y_min);
+        x_axis.ExtendFitWith(y_axis, x_max, y_max);
+        const double x_alt = ImClamp(x_axis.Range.Min, x_min, x_max);
+        y_axis.ExtendFitWith(x_axis, y_min, x_alt);
+        y_axis.ExtendFitWith(x_axis, y_max, x_alt);
+    }
+    const BarStackTimeline<T>* const* lanes;
+    const int    lane_count;
+    const double half_height;
+    const double spacing;
+    const double shift;
+};
+
+// Bars of all visible lanes, in the layout read by RendererBarStackPixH with a y_stride of 1
+struct LaneBuffers {
+    ImVector<float> px_min;
+    ImVector<float> px_max;
+    ImVector<float> y_min;
+    ImVector<float> y_max;
+    ImVector<ImU32> colors;
+};
+
+static LaneBuffers& get_lane_buffers() {
+    static LaneBuffers buffers;
+    return buffers;
+}
+
+static const uint64_t LANES_HASH_SEED = 0xCBF29CE484222325ull; // FNV-1a offset basis
+
+// One FNV-1a step per value instead of per byte, any single changed value still changes the result
+template <typename T>
+static uint64_t lanes_hash(uint64_t hash, T value) {
+    return (hash ^ follow_bits(value)) * 0x100000001B3ull;
+}
+
+// Combined version of the lanes and their layout along Y, part of the key of the cached output of the item.
+// A 64 bit hash, as a 32 bit one would collide within hours of changing lanes.
+template <typename T>
+static uint64_t lanes_version(const BarStackTimeline<T>* const* lanes, int lane_count, double lane_spacing) {
+    uint64_t hash = lanes_hash(LANES_HASH_SEED, lane_spacing);
+    for (int i = 0; i < lane_count; ++i)
+        hash = lanes_hash(lanes_hash(hash, (const void*)lanes[i]), lanes[i]->version);
+    return hash;
+}
+
+static void lane_append(const float* px_min, const float* px_max, const ImU32* colors, int count, float y_min, float y_max, LaneBuffers& out) {
+    const int size = out.px_min.Size;
+    out.px_min.resize(size + count);
+    out.px_max.resize(size + count);
+    out.y_min.resize(size + count);
+    out.y_max.resize(size + count);
+    out.colors.resize(size + count);
+    memcpy(out.px_min.Data + size, px_min, count * sizeof(float));
+    memcpy(out.px_max.Data + size, px_max, count * sizeof(float));
+    memcpy(out.colors.Data + size, colors, count * sizeof(ImU32));
+    for (int i = size; i < size + count; ++i) {
+        out.y_min.Data[i] = y_min;
+        out.y_max.Data[i] = y_max;
+    }
+}
+
+template <typename T>
+void plot_bar_stack_lanes(const char* label_id, const BarStackTimeline<T>* const* lanes, int lane_count, double group_size, double lane_spacing, double shift, ImPlotBarGroupsFlags flags) {
+    const bool horz = ImHasFlag(flags, ImPlotBarGroupsFlags_Horizontal);
+    ImPlot::SetupLock();
+    // the next palette applies to every lane of the item
+    const BarStackPalette item_palette = next_palette;
+    next_palette = BarStackPalette();
+    if (!horz || lane_count <= 0)
+        return;
+    int segments = 0;
+    for (int i = 0; i < lane_count; ++i)
+        segments += lanes[i]->count();
+    StatsScope stats(label_id, segments);
+    if (ImPlot::BeginItemEx(label_id, FitterBarStackLanesH<T>(lanes, lane_count, group_size, lane_spacing, shift), 0, ImPlotCol_Fill)) {
+        ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+        const ImPlotAxis& x_axis = plot.Axes[plot.CurrentX];
+        const ImPlotAxis& y_axis = plot.Axes[plot.CurrentY];
+        const Transformer1 t_x(plot.Axes[plot.CurrentX]);
+        const Transformer1 t_y(plot.Axes[plot.CurrentY]);
+        const ImGuiID item_id = ImPlot::GetCurrentItem()->ID;
+        ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+        VertexCacheEntry& cached = get_item_entry<VertexCacheEntry>(item_id);
+        active_palette = item_palette;
+        const StackKey key = vertex_key(lanes, lanes_version(lanes, lane_count, lane_spacing), lane_count, plot, draw_list, group_size, shift, flags);
+        if (vertex_cache_replay(draw_list, cached, key)) {
+            end_item();
+            return;
+        }
+        const VertexCapture capture(draw_list);
+        // lanes whose centers lie within half a lane height of the visible Y range
+        const double half_height = group_size * 0.5;
+        int first = 0;
+        int last = lane_count;
+        if (lane_spacing > 0) {
+            first = (int)ImClamp(std::ceil((y_axis.Range.Min - half_height - shift) / lane_spacing), 0.0, (double)lane_count);
+            last = (int)ImClamp(std::floor((y_axis.Range.Max + half_height - shift) / lane_spacing) + 1, 0.0, (double)lane_count);
+        }
+        LaneBuffers& buffers = get_lane_buffers();
+        buffers.px_min.resize(0);
+        buffers.px_max.resize(0);
+        buffers.y_min.resize(0);
+        buffers.y_max.resize(0);
+        buffers.colors.resize(0);
+        for (int i = first; i < last; ++i) {
+            const BarStackTimeline<T>& lane = *lanes[i];
+            const double lane_shift = shift + i * lane_spacing;
+            if (lane.count() == 0 || lane_shift + half_height < y_axis.Range.Min || lane_shift - half_height > y_axis.Range.Max)
+                continue;
+            float y_min, y_max;
+            lane_to_pixels(t_y, group_size, lane_shift, &y_min, &y_max);
+            // draws the lane from its strip when BarStackFlags_Strip is set, else collects its bars
+            const ImGuiID lane_id = ImHashData(&i, sizeof(i), item_id);
+            auto plot_lane = [&](const auto& index, const auto& colorer, int count) {
+                if (ImHasFlag(flags, BarStackFlags_Strip) && plot_strip(lane_id, index, colorer, count, y_min, y_max, flags))
+                    return;
+                if (ImHasFlag(flags, BarStackFlags_Follow) && follow_bars(lane_id, index, colorer, count, flags)) {
+                    const FollowBuffers& lane_bars = get_follow_buffers();
+                    lane_append(lane_bars.px_min.Data, lane_bars.px_max.Data, lane_bars.colors.Data, lane_bars.px_min.Size, y_min, y_max, buffers);
+                    return;
+                }
+                collect_bars(lane_id, index, colorer, count, t_x, flags, [&](const float* px_min, const float* px_max, const ImU32* colors, int n) {
+                    lane_append(px_min, px_max, colors, n, y_min, y_max, buffers);
+                });
+            };
+            const bool pyramid_colors = item_palette.colors == nullptr && (lane.palette.colors != nullptr || !ImHasFlag(flags, BarStackFlags_Categorical) || default_palette_is_categorical<T>());
+            const int level = lane.pyramid.enabled() && pyramid_colors && x_axis.TransformForward == nullptr ? lane.pyramid.pick_level(ImAbs(x_axis.ScaleToPixel)) : -1;
+            if (level >= 0) {
+                const BarStackPyramidLevel& pyramid_level = lane.pyramid.levels[level];
+                plot_lane(pyramid_level, ColorerPyramid(pyramid_level, flags), pyramid_level.count());
+                continue;
+            }
+            next_palette = item_palette;
+            with_palette<T>(lane.palette, flags, [&](const auto& palette) {
+                typedef typename std::decay<decltype(palette)>::type Palette;
+                plot_lane(lane, ColorerValue<T, Palette, ImVector<T>>(lane.states, palette), lane.count());
+            });
+        }
+        RendererBarStackPixH renderer(buffers.px_min.Data, buffers.px_max.Data, buffers.colors.Data, buffers.px_min.Size, buffers.y_min.Data, buffers.y_max.Data, 1);
+        if (ImHasFlag(flags, BarStackFlags_Parallel))
+            RenderPrimitivesParallel(renderer, draw_list, plot.PlotRect);
+        else
+            RenderPrimitivesEx(renderer, draw_list, plot.PlotRect);
+        vertex_cache_store(draw_list, capture, key, cached);
+        end_item();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Hover
+//-----------------------------------------------------------------------------
+// The segment under the mouse is found with the same binary search as the visible range, so hovering costs O(log n)
+// per lane instead of a scan over the lengths, and the lane is computed from the mouse Y.
+
+// Returns the segment containing x, or -1 when x is outside the stack
+template <typename Index>
+int find_segment(const Index& index, int count, double x) {
+    int first, last;
+    index.find_visible(x, x, &first, &last);
+    last = ImMin(last, count);
+    // more than one candidate only on a boundary, or when negative lengths make the range span both sides of 0
+    for (int i = first; i < last; ++i) {
+        if (index.segment_min(i) <= x && x <= index.segment_max(i))
+            return i;
+    }
+    return -1;
+}
+
+template <typename T>
+bool hover_lane(const BarStackTimeline<T>& lane, int lane_idx, double group_size, double center, const ImPlotPoint& mouse, BarStackHover<T>* hover) {
+    const double half_height = group_size * 0.5;
+    if (mouse.y < center - half_height || mouse.y > center + half_height)
+        return false;
+    const int segment = find_segment(lane, lane.count(), mouse.x);
+    if (segment < 0)
+        return false;
+    hover->lane = lane_idx;
+    hover->segment = segment;
+    hover->timed = true;
+    hover->start = lane.starts[segment];
+    hover->duration = lane.durations[segment];
+    hover->value = lane.states[segment];
+    hover->x_min = lane.segment_min(segment);
+    hover->x_max = lane.segment_max(segment);
+    hover->y_min = center - half_height;
+    hover->y_max = center + half_height;
+    return true;
+}
+
+template <typename T>
+bool hover_bar_stack(const char* label_id, const BarStackTimeline<T>& timeline, double group_size, double shift, BarStackHover<T>* hover) {
+    if (!ImPlot::IsPlotHovered() || is_item_hidden(label_id))
+        return false;
+    return hover_lane(timeline, 0, group_size, shift, ImPlot::GetPlotMousePos(), hover);
+}
+
+template <typename T>
+bool hover_bar_stack(const char* label_id, const BarStackIndex& index, const std::vector<T>& bar_value, double group_size, double shift, BarStackHover<T>* hover) {
+    if (!ImPlot::IsPlotHovered() || is_item_hidden(label_id))
+        return false;
+    const ImPlotPoint mouse = ImPlot::GetPlotMousePos();
+    const double half_height = group_size * 0.5;
+    if (mouse.y < shift - half_height || mouse.y > shift + half_height)
+        return false;
+    const int segment = find_segment(index, ImMin(index.count(), (int)bar_value.size()), mouse.x);
+    if (segment < 0)
+        return false;
+    hover->lane = 0;
+    hover->segment = segment;
+    hover->timed = false;
+    hover->start = 0;
+    hover->duration = 0;
+    hover->value = bar_value[segment];
+    hover->x_min = index.segment_min(segment);
+    hover->x_max = index.segment_max(segment);
+    hover->y_min = shift - half_height;
+    hover->y_max = shift + half_height;
+    return true;
+}
+
+template <typename T>
+bool hover_bar_stack_lanes(const char* label_id, const BarStackTimeline<T>* const* lanes, int lane_count, double group_size, double lane_spacing, double shift, BarStackHover<T>* hover) {
+    if (!ImPlot::IsPlotHovered() || lane_count <= 0 || is_item_hidden(label_id))
+        return false;
+    const ImPlotPoint mouse = ImPlot::GetPlotMousePos();
+    if (lane_spacing != 0) {
+        // the nearest lane center is the only candidate
+        const double lane = std::floor((mouse.y - shift) / lane_spacing + 0.5);
+        if (lane < 0 || lane >= lane_count)
+            return false;
+        const int i = (int)lane;
+        return hover_lane(*lanes[i], i, group_size, shift + i * lane_spacing, mouse, hover);
+    }
+    for (int i = 0; i < lane_count; ++i) {
+        if (hover_lane(*lanes[i], i, group_size, shift, mouse, hover))
+            return true;
+    }
+    return false;
+}
+
+template <typename T>
+void show_bar_stack_hover(const BarStackHover<T>& hover, const char* const* state_labels, int state_count) {
+    const ImVec2 p1 = ImPlot::PlotToPixels(hover.x_min, hover.y_min);
+    const ImVec2 p2 = ImPlot::PlotToPixels(hover.x_max, hover.y_max);
+    ImPlot::PushPlotClipRect();
+    ImPlot::GetPlotDrawList()->AddRect(ImMin(p1, p2), ImMax(p1, p2), ImPlot::GetStyleColorU32(ImPlotCol_InlayText), 0.0f, 0, 2.0f);
+    ImPlot::PopPlotClipRect();
+    const long long state = (long long)hover.value;
+    const char* label = state_labels != nullptr && state >= 0 && state < state_count ? state_labels[state] : nullptr;
+    if (!hover.timed && label != nullptr)
+        ImGui::SetTooltip("from %g\nto %g\nvalue %s", hover.x_min, hover.x_max, label);
+    else if (!hover.timed)
+        ImGui::SetTooltip("from %g\nto %g\nvalue %lld", hover.x_min, hover.x_max, state);
+    else if (label != nullptr)
+        ImGui::SetTooltip("start %llu\nduration %llu\nvalue %s", (unsigned long long)hover.start, (unsigned long long)hover.duration, label);
+    else
+        ImGui::SetTooltip("start %llu\nduration %llu\nvalue %lld", (unsigned long long)hover.start, (unsigned long long)hover.duration, state);
+}
+
+//-----------------------------------------------------------------------------
+// [SECTION] Labels
+//-----------------------------------------------------------------------------
+// A label is only laid out on a segment whose visible part is wide enough for its text plus the minimum spacing.
+// The layout walks the plot from left to right with one binary search per step and moves at least one pixel per step,
+// so its cost is bounded by the plot width instead of the number of transitions. The glyphs of all labels are then
+// rendered in one pass with a single reservation.
+
+struct LabelBuffers {
+    ImVector<float>      widths; // text width of each state label
+    ImVector<LabelGlyph> glyphs;
+};
+
+static LabelBuffers& get_label_buffers() {
+    static LabelBuffers buffers;
+    return buffers;
+}
+
+// Glyphs of the current font. Dear ImGui 1.92 bakes the glyphs of each font size into an ImFontBaked, earlier versions
+// scale those of the one size an ImFont is baked at.
+#if IMGUI_VERSION_NUM >= 19200
+typedef ImFontBaked LabelFont;
+static LabelFont* label_font() { return ImGui::GetFontBaked(); }
+static float label_font_scale(const LabelFont* font) { return ImGui::GetFontSize() / font->Size; }
+#else
+typedef ImFont LabelFont;
+static LabelFont* label_font() { return ImGui::GetFont(); }
+static float label_font_scale(const LabelFont* font) { return ImGui::GetFontSize() / font->FontSize; }
+#endif
+
+// Appends the glyphs of text with its top left corner at pos
+static void label_glyphs(LabelFont* font, float scale, ImVec2 pos, const char* text, ImVector<LabelGlyph>& out) {
+    // snapped to whole pixels like ImFont::RenderText
+    pos.x = ImFloor(pos.x);
+    pos.y = ImFloor(pos.y);
+    const char* s = text;
+    while (*s) {
+        unsigned int c = (unsigned int)*s;
+        if (c < 0x80)
+            s += 1;
+        else
+            s += ImTextCharFromUtf8(&c, s, nullptr);
+        const ImFontGlyph* glyph = font->FindGlyph((ImWchar)c);
+        if (glyph == nullptr)
+            continue;
+        if (glyph->Visible) {
+            LabelGlyph g;
+            g.p_min = ImVec2(pos.x + glyph->X0 * scale, pos.y + glyph->Y0 * scale);
+            g.p_max = ImVec2(pos.x + glyph->X1 * scale, pos.y + glyph->Y1 * scale);
+            g.glyph = glyph;
+            out.push_back(g);
+        }
+        pos.x += glyph->AdvanceX * scale;
+    }
+}
+
+// Lays out the labels of the segments of a lane centered at shift, state_labels[state] is drawn on segments in that state
+template <typename Index, typename States>
+void label_layout(const Index& index, const States& states, int count, const char* const* state_labels, int state_count, double shift, float min_spacing, ImVector<LabelGlyph>& out) {
+    ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+    const ImPlotAxis& x_axis = plot.Axes[plot.CurrentX];
+    const Transformer1 t_x(x_axis);
+    const Transformer1 t_y(plot.Axes[plot.CurrentY]);
+    LabelFont* font = label_font();
+    const float font_size = ImGui::GetFontSize();
+    const float scale = label_font_scale(font);
+    const float* widths = get_label_buffers().widths.Data;
+    const float y = t_y(shift) - font_size * 0.5f;
+    // walks in the direction of increasing X, which is leftwards on an inverted axis
+    const bool inverted = x_axis.PixelMax < x_axis.PixelMin;
+    float cursor = x_axis.PixelMin;
+    int prev = -1;
+    while (inverted ? cursor > x_axis.PixelMax : cursor < x_axis.PixelMax) {
+        int idx, last;
+        index.find_visible(x_axis.PixelsToPlot(cursor), x_axis.PixelsToPlot(cursor), &idx, &last);
+        idx = ImMax(idx, prev + 1);
+        if (idx >= count)
+            break;
+        prev = idx;
+        const float p0 = t_x(index.segment_min(idx));
+        const float p1 = t_x(index.segment_max(idx));
+        const float lo = ImMax(ImMin(p0, p1), plot.PlotRect.Min.x);
+        const float hi = ImMin(ImMax(p0, p1), plot.PlotRect.Max.x);
+        const long long state = (long long)states[idx];
+        if (state >= 0 && state < state_count && state_labels[state] != nullptr && hi - lo >= widths[state] + min_spacing)
+            label_glyphs(font, scale, ImVec2((lo + hi - widths[state]) * 0.5f, y), state_labels[state], out);
+        cursor = inverted ? ImMin(p1, cursor - 1.0f) : ImMax(p1, cursor + 1.0f);
+    }
+}
+
+// Measures the state labels, once per call instead of once per label
+static void label_measure(const char* const* state_labels, int state_count) {
+    ImVector<float>& widths = get_label_buffers().widths;
+    widths.resize(state_count);
+    for (int s = 0; s < state_count; ++s)
+        widths[s] = state_labels[s] != nullptr ? ImGui::CalcTextSize(state_labels[s]).x : 0.0f;
+}
+
+static void label_render(const ImVector<LabelGlyph>& glyphs) {
+    ImPlot::PushPlotClipRect();
+    RenderPrimitivesEx(RendererLabelGlyphs(glyphs.Data, glyphs.Size, ImPlot::GetStyleColorU32(ImPlotCol_InlayText)), *ImPlot::GetPlotDrawList(), ImPlot::GetCurrentPlot()->PlotRect);
+    ImPlot::PopPlotClipRect();
+}
+
+template <typename T>
+void plot_bar_stack_labels(const char* label_id, const BarStackTimeline<T>& timeline, const char* const* state_labels, int state_count, double shift, float min_spacing) {
+    ImPlot::SetupLock();
+    if (is_item_hidden(label_id))
+        return;
+    LabelBuffers& buffers = get_label_buffers();
+    label_measure(state_labels, state_count);
+    buffers.glyphs.resize(0);
+    label_layout(timeline, timeline.states, timeline.count(), state_labels, state_count, shift, min_spacing, buffers.glyphs);
+    label_render(buffers.glyphs);
+}
+
+template <typename T>
+void plot_bar_stack_lanes_labels(const char* label_id, const BarStackTimeline<T>* const* lanes, int lane_count, double lane_spacing, double shift, const char* const* state_labels, int state_count, float min_spacing) {
+    ImPlot::SetupLock();
+    if (is_item_hidden(label_id))
+        return;
+    LabelBuffers& buffers = get_label_buffers();
+    label_measure(state_labels, state_count);
+    buffers.glyphs.resize(0);
+    // lanes whose centers are inside the visible Y range
+    ImPlotPlot& plot = *ImPlot::GetCurrentPlot();
+    const ImPlotAxis& y_axis = plot.Axes[plot.CurrentY];
+    int first = 0;
+    int last = lane_count;
+    if (lane_spacing > 0) {
+        first = (int)ImClamp(std::ceil((y_axis.Range.Min - shift) / lane_spacing), 0.0, (double)lane_count);
+        last = (int)ImClamp(std::floor((y_axis.Range.Max - shift) / lane_spacing) + 1, 0.0, (double)lane_count);
     }
+    for (int i = first; i < last; ++i)
+        label_layout(*lanes[i], lanes[i]->states, lanes[i]->count(), state_labels, state_count, shift + i * lane_spacing, min_spacing, buffers.glyphs);
+    label_render(buffers.glyphs);
 }
 
 // Explicit template instantiation for the types you expect to be used
 // This is necessary because the template implementation is in the .cpp file
-template void plot_bar_stack<uint64_t, bool>(std::string label_id, const uint64_t* bar_length, std::vector<bool> bar_value, int item_count, double group_size, double shift, ImPlotBarGroupsFlags flags);
-template void plot_bar_stack<uint64_t, int>(std::string label_id, const uint64_t* bar_length, std::vector<int> bar_value, int item_count, double group_size, double shift, ImPlotBarGroupsFlags flags);
+#define INSTANTIATE_LENGTH_MACRO(T1, T) \
+    template void plot_bar_stack<T1, T>(const char* label_id, const T1* bar_length, const std::vector<T>& bar_value, int item_count, double group_size, double shift, ImPlotBarGroupsFlags flags); \
+    template void plot_bar_stack<T1, T>(const char* label_id, const T1* bar_length, const T* bar_value, int count, double group_size, double shift, ImPlotBarGroupsFlags flags, int offset, int length_stride, int value_stride);
+#define INSTANTIATE_MACRO(T) \
+    template struct BarStackTimeline<T>; \
+    template struct BarStackTimelineView<T>; \
+    template struct BarStackCompressedTimeline<T>; \
+    CALL_INSTANTIATE_FOR_LENGTH_TYPES(T) \
+    template void plot_bar_stack<T>(const char* label_id, const BarStackIndex& index, const std::vector<T>& bar_value, double group_size, double shift, ImPlotBarGroupsFlags flags); \
+    template void plot_bar_stack<T>(const char* label_id, const BarStackTimeline<T>& timeline, double group_size, double shift, ImPlotBarGroupsFlags flags); \
+    template void plot_bar_stack<T>(const char* label_id, const BarStackTimelineView<T>& view, double group_size, double shift, ImPlotBarGroupsFlags flags); \
+    template void plot_bar_stack<T>(const char* label_id, const BarStackCompressedTimeline<T>& timeline, double group_size, double shift, ImPlotBarGroupsFlags flags); \
+    template void plot_bar_stack_timestamps<T>(const char* label_id, const uint64_t* timestamps, const T* states, int count, double group_size, double shift, ImPlotBarGroupsFlags flags); \
+    template void plot_bar_stack_lanes<T>(const char* label_id, const BarStackTimeline<T>* const* lanes, int lane_count, double group_size, double lane_spacing, double shift, ImPlotBarGroupsFlags flags); \
+    template void plot_bar_stack_labels<T>(const char* label_id, const BarStackTimeline<T>& timeline, const char* const* state_labels, int state_count, double shift, float min_spacing); \
+    template void plot_bar_stack_lanes_labels<T>(const char* label_id, const BarStackTimeline<T>* const* lanes, int lane_count, double lane_spacing, double shift, const char* const* state_labels, int state_count, float min_spacing); \
+    template bool hover_bar_stack<T>(const char* label_id, const BarStackTimeline<T>& timeline, double group_size, double shift, BarStackHover<T>* hover); \
+    template bool hover_bar_stack<T>(const char* label_id, const BarStackIndex& index, const std::vector<T>& bar_value, double group_size, double shift, BarStackHover<T>* hover); \
+    template bool hover_bar_stack_lanes<T>(const char* label_id, const BarStackTimeline<T>* const* lanes, int lane_count, double group_size, double lane_spacing, double shift, BarStackHover<T>* hover); \
+    template void show_bar_stack_hover<T>(const BarStackHover<T>& hover, const char* const* state_labels, int state_count);
+CALL_INSTANTIATE_FOR_STATE_TYPES()
+#undef INSTANTIATE_MACRO
+#undef INSTANTIATE_LENGTH_MACRO
@@ -1,8 +1,423 @@
 #pragma once
 #include "implot.h"
+#include "bar_stack_indexers.h"
 
+#include <cstdint>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+// Calls INSTANTIATE_MACRO for every state type plot_bar_stack is instantiated for, like CALL_INSTANTIATE_FOR_NUMERIC_TYPES in implot_items.cpp.
+// The functions reading states from arrays or std::vector also take enums, and plot them as BarStackEnumState<E> with BarStackFlags_Categorical.
+// Timelines, views, compressed timelines and BarStackIndex overloads only take these types, keep enum states in them as BarStackEnumState<E>
+// and pass BarStackFlags_Categorical.
+// long and unsigned long are distinct from the ImS64 and ImU64 of Dear ImGui (long long), and are int64_t and uint64_t on LP64 targets.
+#define CALL_INSTANTIATE_FOR_STATE_TYPES() \
+    INSTANTIATE_MACRO(bool)                 \
+    INSTANTIATE_MACRO(ImS8)                 \
+    INSTANTIATE_MACRO(ImU8)                 \
+    INSTANTIATE_MACRO(ImS16)                \
+    INSTANTIATE_MACRO(ImU16)                \
+    INSTANTIATE_MACRO(ImS32)                \
+    INSTANTIATE_MACRO(ImU32)                \
+    INSTANTIATE_MACRO(ImS64)                \
+    INSTANTIATE_MACRO(ImU64)                \
+    INSTANTIATE_MACRO(long)                 \
+    INSTANTIATE_MACRO(unsigned long)
+
+// Calls INSTANTIATE_LENGTH_MACRO(T1, T) for every length type the raw array overloads of plot_bar_stack are instantiated for
+#define CALL_INSTANTIATE_FOR_LENGTH_TYPES(T)  \
+    INSTANTIATE_LENGTH_MACRO(float, T)        \
+    INSTANTIATE_LENGTH_MACRO(double, T)       \
+    INSTANTIATE_LENGTH_MACRO(int32_t, T)      \
+    INSTANTIATE_LENGTH_MACRO(uint32_t, T)     \
+    INSTANTIATE_LENGTH_MACRO(int64_t, T)      \
+    INSTANTIATE_LENGTH_MACRO(uint64_t, T)
+
+// State type of CALL_INSTANTIATE_FOR_STATE_TYPES with the size and signedness of the underlying type of enum E.
+// The underlying type itself may be one without an instantiation, like char or wchar_t.
+template <typename E, typename U = typename std::underlying_type<E>::type>
+using BarStackEnumState =
+    typename std::conditional<sizeof(U) == 1, typename std::conditional<std::is_signed<U>::value, ImS8, ImU8>::type,
+    typename std::conditional<sizeof(U) == 2, typename std::conditional<std::is_signed<U>::value, ImS16, ImU16>::type,
+    typename std::conditional<sizeof(U) == 4, typename std::conditional<std::is_signed<U>::value, ImS32, ImU32>::type,
+    typename std::conditional<std::is_signed<U>::value, ImS64, ImU64>::type>::type>::type>::type;
+
+// Additional flags for plot_bar_stack, they can be combined with ImPlotBarGroupsFlags
+enum BarStackFlags_ {
+    BarStackFlags_None        = 0,
+    BarStackFlags_NoLod       = 1 << 20, // draw every segment, even when several segments fall into the same pixel column
+    BarStackFlags_LodBlend    = 1 << 21, // color aggregated pixel columns with the duration weighted blend of their segment colors instead of the dominant one
+    BarStackFlags_LodMarker   = 1 << 22, // color aggregated pixel columns holding more than one color with a neutral "many transitions" marker color
+    BarStackFlags_Parallel    = 1 << 23, // generate the vertices of large stacks drawn with BarStackFlags_NoLod on several threads, the output is the same
+    BarStackFlags_Strip       = 1 << 24, // rasterise each lane into a cached texture row and draw it as one textured quad, needs set_bar_stack_texture_backend().
+                                         // On a linear X axis the row spans the atlas width around the view and panning only moves the quad over it
+    BarStackFlags_Follow      = 1 << 25, // keep the bars of finalised segments across frames and only convert the appended ones, for views following the end of
+                                         // data with non-negative lengths. Any change other than an append, told by the version of the data, drops the kept bars.
+                                         // Raw arrays have no version and are taken as append only: a grown count appends, a smaller count,
+                                         // another array, or another length or value in the first or last entry kept starts over.
+                                         // Plot data edited elsewhere in place from a BarStackIndex, whose version tells edits.
+                                         // Unless BarStackFlags_NoLod is set the kept bars are only reused while the view scrolls by whole pixels.
+    BarStackFlags_Categorical = 1 << 26, // color states without a palette with the colors of ImPlotColormap_Deep whatever their type, instead of the sign
+                                         // colors of signed integers or the red and blue of bool. States past the 10 Deep colors get hues spread by the golden ratio.
+                                         // The enum overloads set it, pass it when plotting BarStackEnumState<E>.
+};
+
+// Returns a version above both version and any version handed out before, from the counter shared by all stacks.
+// Use it for data versioned by hand, like a BarStackTimelineView, so it never repeats the version of other data.
+uint64_t next_bar_stack_version(uint64_t version = 0);
+
+// Cumulative offsets of the segments of a bar stack.
+// Build it once and keep it next to the data, so plot_bar_stack only has to visit the segments inside the visible X range.
+struct BarStackIndex {
+    BarStackIndex();
+    void clear();
+    // offset and stride follow ImPlot's conventions, so interleaved records and circular buffers can be indexed in place.
+    // T is one of the types of CALL_INSTANTIATE_FOR_LENGTH_TYPES
+    template <typename T> void build(const T* bar_length, int count, int offset = 0, int stride = sizeof(T));
+    void append(double bar_length);
+    int count() const { return pos.Size - 1; }
+    // Extents of a segment along the stacking axis, positive lengths stack from 0 to the right and negative ones to the left
+    double segment_min(int idx) const { return pos[idx + 1] > pos[idx] ? pos[idx] : (neg.empty() ? 0.0 : neg[idx + 1]); }
+    double segment_max(int idx) const { return pos[idx + 1] > pos[idx] ? pos[idx + 1] : (neg.empty() ? 0.0 : neg[idx]); }
+    // Extents of segments [0, count) in O(1), the stack always touches 0 and the sums grow away from it
+    double stack_min(int count) const { return neg.empty() ? 0.0 : neg[count]; }
+    double stack_max(int count) const { return pos[count]; }
+    // Returns the range [first, last) of the segments overlapping [x_min, x_max], found by binary search
+    void find_visible(double x_min, double x_max, int* first, int* last) const;
+
+    ImVector<double> pos; // pos[i] is the sum of the positive lengths before segment i, it has count() + 1 entries
+    ImVector<double> neg; // same for the negative lengths, stays empty until the first negative length is appended
+    uint64_t         version;        // raised on every change, so caches can tell when the data changed. Versions come from one counter
+                                     // shared by all stacks, a rebuilt index never repeats the version of the data it replaced.
+    uint64_t         append_version; // version after the last append(), any other change leaves version ahead of it
+    uint64_t         edit_version;   // last version reached by a change other than append(), as seen by the next append()
+};
+
+// Dense lookup table from state ids to colors, states outside [0, count) are drawn with fallback.
+// The colors are not copied and must outlive the plot calls using the palette.
+struct BarStackPalette {
+    BarStackPalette(const ImU32* colors = nullptr, int count = 0, ImU32 fallback = IM_COL32_WHITE) : colors(colors), count(count), fallback(fallback) { }
+    const ImU32* colors;
+    int          count;
+    ImU32        fallback;
+};
+
+// Colors the next plot_bar_stack call with palette instead of the default colors of its state type. Timelines are then plotted
+// from their segments, their pyramid levels hold the colors of their own palette.
+void set_next_bar_stack_palette(const BarStackPalette& palette);
+
+// Counters of one plot_bar_stack call
+struct BarStackStats {
+    char   label[64];
+    int    segments;        // segments passed in
+    int    segments_hidden; // segments skipped before rendering: hidden item, outside the visible X range or in a lane outside the Y range
+    int    segments_scanned; // segments looked at for runs of one color, from a window around the visible ones
+    int    prims;           // primitives handed to the renderer, after level of detail aggregation
+    int    prims_culled;    // primitives culled against the plot rect
+    int    vtx_reserved;
+    int    idx_reserved;
+    int    vtx_unreserved;
+    int    idx_unreserved;
+    int    draw_cmd_splits; // draw commands started because the vertex index reached MaxIdx
+    int    vtx_replayed;    // vertices copied from the output of the last frame instead of being generated
+    double elapsed_ms;
+};
+
+// Stats of every plot_bar_stack call of the current frame, in call order. The first call of the next frame resets them.
+const ImVector<BarStackStats>& get_bar_stack_stats();
+// Optional ImGui window listing the most expensive stacks of the current frame
+void show_bar_stack_stats_window(bool* p_open = nullptr, int max_rows = 16);
+
+// Texture callbacks of the renderer backend, BarStackFlags_Strip uploads its atlas of RGBA rows through them.
+// All three are needed: the atlas texture is created again when it grows, and the replaced one is handed to destroy
+// once the frames drawing it are rendered.
+struct BarStackTextureBackend {
+    BarStackTextureBackend() : create(nullptr), update(nullptr), destroy(nullptr) { }
+    ImTextureID (*create)(int width, int height, const ImU32* pixels);
+    void        (*update)(ImTextureID texture, int y, int width, int height, const ImU32* pixels); // rows [y, y + height), pixels of the first row
+    void        (*destroy)(ImTextureID texture);
+};
+
+void set_bar_stack_texture_backend(const BarStackTextureBackend& backend);
+
+// Rasterises bars given in screen pixels into a row of width RGBA pixels, column c covering x_origin + c.
+// A column takes the color of the last bar covering its center, columns no bar covers are left untouched.
+void rasterize_bar_stack_strip(const float* px_min, const float* px_max, const ImU32* colors, int count, float x_origin, int width, ImU32* row);
+
+static const int BAR_STACK_PYRAMID_COLORS     = 4;  // colors kept per pyramid run, further colors are dropped from the run
+static const int BAR_STACK_PYRAMID_MAX_LEVELS = 48;
+
+// A run of a pyramid level: the time it covers and how much of that time each color takes
+struct BarStackPyramidRun {
+    uint64_t start;
+    uint64_t end;
+    uint64_t bin;         // bin of the merged short segments, or UINT64_MAX when the run is a single long segment
+    ImU32    colors[BAR_STACK_PYRAMID_COLORS];
+    float    weights[BAR_STACK_PYRAMID_COLORS];
+    int      color_count;
+    int      first;       // first segment of the timeline merged into the run
+};
+
+// One level of a BarStackPyramid: consecutive segments shorter than bin_width that start in the same bin are merged into one run
+struct BarStackPyramidLevel {
+    BarStackPyramidLevel() : bin_width(0), skipped(false), version(0), append_version(0), edit_version(0) { }
+    void append(uint64_t origin, int segment, uint64_t start, uint64_t duration, ImU32 color);
+    // Grows the last segment appended from old_duration to duration. Returns false when it grew out of the bin of the run
+    // it was merged into, that run then has to be dropped and its segments appended again.
+    bool extend(uint64_t origin, uint64_t start, uint64_t old_duration, uint64_t duration, ImU32 color);
+    int count() const { return runs.Size; }
+    double segment_min(int idx) const { return (double)runs[idx].start; }
+    double segment_max(int idx) const { return (double)runs[idx].end; }
+    double stack_min(int) const { return (double)runs[0].start; }
+    double stack_max(int count) const { return (double)runs[count - 1].end; }
+    void find_visible(double x_min, double x_max, int* first, int* last) const;
+
+    uint64_t                     bin_width;
+    bool                         skipped;        // merges too few runs of the finer levels to be kept, has no runs and is never picked
+    ImVector<BarStackPyramidRun> runs;
+    uint64_t                     version;        // raised on every change of runs, same as in BarStackIndex
+    uint64_t                     append_version; // same as in BarStackIndex, appending may also extend the last run
+    uint64_t                     edit_version;
+};
+
+// Optional mipmap-like summary of a BarStackTimeline for zoomed out views, level k merges segments on a grid of base_width * 2^k.
+// Coarser levels are added as the timeline grows, until the coarsest bin spans the whole timeline or its width would overflow.
+// Once the timeline is long enough to tell, a level holding more than 3/4 of the runs of the finer level is skipped.
+// Skipped levels are built and looked at again each time the timeline doubles.
+struct BarStackPyramid {
+    BarStackPyramid() : base_width(0), level_count(0), revisit_count(0) { }
+    bool enabled() const { return base_width != 0; }
+    // Returns the coarsest level whose bins are at most one pixel wide, or -1 when the segments should be drawn directly
+    int pick_level(double pixels_per_unit) const;
+
+    uint64_t             base_width;
+    int                  level_count;
+    int                  revisit_count; // segments of the timeline when the skipped levels were last built again
+    BarStackPyramidLevel levels[BAR_STACK_PYRAMID_MAX_LEVELS];
+};
+
+// Transitions of one state lane, stored as a structure of arrays so plot_bar_stack can read them in place.
+// Appending is amortised O(1) and nothing has to be converted per frame.
+template <typename T>
+struct BarStackTimeline {
+    static_assert(!std::is_enum<T>::value, "keep enum states as BarStackEnumState<E>");
+    BarStackTimeline(uint64_t origin = 0);
+    void clear();
+    void reserve(int capacity);
+    // Appends a segment starting where the previous one ends, it closes the open segment of push_transition()
+    void append(uint64_t duration, T state);
+    // Records a sample of the lane state at timestamp, for transitions arriving one by one. The last segment is kept open and
+    // extended to the latest sample, so it is plotted, fitted and hovered like the others. A sample in another state closes
+    // it at timestamp and opens a new one, repeated samples of the open state only extend it.
+    // A segment added by append() is extended the same way, segments stay contiguous: append(10, a) then
+    // push_transition(50, b) gives a over [0, 50) and b opened at 50.
+    void push_transition(uint64_t timestamp, T state);
+    int count() const { return durations.Size; }
+    uint64_t end() const { return durations.empty() ? origin : starts.back() + durations.back(); }
+    double segment_min(int idx) const { return (double)starts[idx]; }
+    double segment_max(int idx) const { return (double)(starts[idx] + durations[idx]); }
+    double stack_min(int) const { return (double)starts[0]; }
+    double stack_max(int count) const { return segment_max(count - 1); }
+    // Returns the range [first, last) of the segments overlapping [x_min, x_max], found by binary search
+    void find_visible(double x_min, double x_max, int* first, int* last) const;
+    // Builds a pyramid with a finest bin width of base_width time units, append() then keeps it up to date
+    void enable_pyramid(uint64_t base_width);
+    // Colors this timeline with palette instead of the default colors of T, the pyramid is rebuilt with it
+    void set_palette(const BarStackPalette& palette);
+
+    uint64_t           origin;    // start time of the first segment
+    ImVector<uint64_t> starts;    // start time of each segment
+    ImVector<uint64_t> durations; // duration of each segment
+    ImVector<T>        states;    // state of each segment
+    bool               has_open;  // the last segment was opened by push_transition() and ends at its latest sample
+    BarStackPyramid    pyramid;   // only maintained after enable_pyramid()
+    BarStackPalette    palette;
+    uint64_t           version;        // same as in BarStackIndex
+    uint64_t           append_version; // same as in BarStackIndex
+    uint64_t           edit_version;
+};
+
+// Read-only view of timeline columns owned elsewhere, e.g. by a memory-mapped BarStackCaptureFile.
+// plot_bar_stack reads it in place: finding the visible range touches O(log n) entries of starts, then only the visible segments.
+template <typename T>
+struct BarStackTimelineView {
+    static_assert(!std::is_enum<T>::value, "keep enum states as BarStackEnumState<E>");
+    BarStackTimelineView() : starts(nullptr), durations(nullptr), states(nullptr), segments(0), origin(0), version(0) { }
+    int count() const { return segments; }
+    double segment_min(int idx) const { return (double)starts[idx]; }
+    double segment_max(int idx) const { return (double)(starts[idx] + durations[idx]); }
+    double stack_min(int) const { return (double)starts[0]; }
+    double stack_max(int count) const { return segment_max(count - 1); }
+    void find_visible(double x_min, double x_max, int* first, int* last) const;
+
+    const uint64_t* starts;    // start time of each segment, non-decreasing
+    const uint64_t* durations;
+    const T*        states;
+    int             segments;
+    uint64_t        origin;    // start time of the first segment, same as in BarStackTimeline
+    uint64_t        version;   // must change whenever the viewed data changes, caches of the plotted output are keyed on it.
+                               // Take it from next_bar_stack_version(). A view can not tell appends from edits, so BarStackFlags_Follow
+                               // drops its kept bars on every change
+};
+
+static const int BAR_STACK_BLOCK_SEGMENTS = 512; // segments per block of a BarStackCompressedTimeline
+
+// Block of BAR_STACK_BLOCK_SEGMENTS segments of a BarStackCompressedTimeline, decodable on its own.
+// Durations and states are stored as their difference to the smallest value of the block, with the bits the largest difference needs.
+struct BarStackBlock {
+    uint64_t start;         // start time of the first segment
+    uint64_t end;           // end time of the last segment
+    uint64_t duration_base;
+    uint64_t state_base;
+    uint64_t offset;        // byte offset of the packed durations in BarStackCompressedTimeline::bytes, the packed states follow them
+    ImU8     duration_bits;
+    ImU8     state_bits;    // 1 for bool, 4 or less for small enums
+};
+
+// Transitions of one state lane stored in compressed blocks, for histories too long to keep as plain columns.
+// Segments are appended to an uncompressed tail, which is packed into a block once it is full.
+// plot_bar_stack only decodes the blocks overlapping the visible range, found by binary search on the block bounds.
+template <typename T>
+struct BarStackCompressedTimeline {
+    static_assert(!std::is_enum<T>::value, "keep enum states as BarStackEnumState<E>");
+    BarStackCompressedTimeline(uint64_t origin = 0);
+    void clear();
+    // Appends a segment starting where the previous one ends
+    void append(uint64_t duration, T state);
+    int count() const { return blocks.Size * BAR_STACK_BLOCK_SEGMENTS + tail_durations.Size; }
+    uint64_t end() const { return end_time; }
+    // Decodes the segments of a block into columns of BAR_STACK_BLOCK_SEGMENTS entries
+    void decode(int block, uint64_t* starts, uint64_t* durations, T* states) const;
+    // Returns the range [first, last) of the blocks overlapping [x_min, x_max], the tail is not included
+    void find_blocks(double x_min, double x_max, int* first, int* last) const;
+    // Bytes held by the blocks, the packed data and the tail
+    size_t memory_size() const;
+
+    uint64_t                   origin;         // start time of the first segment
+    ImVector<BarStackBlock>    blocks;
+    std::vector<unsigned char> bytes;          // packed blocks, followed by 8 zero bytes so decoding can always load whole words.
+                                               // Not an ImVector, which can only index 2 GiB
+    ImVector<uint64_t>         tail_durations; // segments not packed yet
+    ImVector<T>                tail_states;
+    uint64_t                   tail_start;     // start time of the first tail segment
+    uint64_t                   end_time;
+    uint64_t                   version;        // same as in BarStackIndex
+};
+
+template <typename T1, typename T2, typename std::enable_if<!std::is_enum<T2>::value, int>::type = 0>
+void plot_bar_stack(const char* label_id, const T1* bar_length, const std::vector<T2>& bar_value, int item_count, double group_size, double shift, ImPlotBarGroupsFlags flags);
+
+// Same as above, but reads lengths and values in place with ImPlot's offset/stride conventions.
+// offset is shared by both arrays (the oldest entry of a circular buffer), the strides are given separately.
+template <typename T1, typename T2, typename std::enable_if<!std::is_enum<T2>::value, int>::type = 0>
+void plot_bar_stack(const char* label_id, const T1* bar_length, const T2* bar_value, int count, double group_size, double shift, ImPlotBarGroupsFlags flags, int offset = 0, int length_stride = sizeof(T1), int value_stride = sizeof(T2));
+
+// Enum states are plotted as BarStackEnumState<E> with BarStackFlags_Categorical
+template <typename T1, typename E, typename std::enable_if<std::is_enum<E>::value, int>::type = 0>
+void plot_bar_stack(const char* label_id, const T1* bar_length, const E* bar_value, int count, double group_size, double shift, ImPlotBarGroupsFlags flags, int offset = 0, int length_stride = sizeof(T1), int value_stride = sizeof(E)) {
+    plot_bar_stack(label_id, bar_length, (const BarStackEnumState<E>*)bar_value, count, group_size, shift, flags | BarStackFlags_Categorical, offset, length_stride, value_stride);
+}
+
+// Enum states of the std::vector overload, plotted through the overload above
+template <typename T1, typename E, typename std::enable_if<std::is_enum<E>::value, int>::type = 0>
+void plot_bar_stack(const char* label_id, const T1* bar_length, const std::vector<E>& bar_value, int item_count, double group_size, double shift, ImPlotBarGroupsFlags flags) {
+    const int count = item_count < (int)bar_value.size() ? item_count : (int)bar_value.size();
+    plot_bar_stack(label_id, bar_length, (const BarStackEnumState<E>*)bar_value.data(), count, group_size, shift, flags | BarStackFlags_Categorical);
+}
+
+// Kept for existing callers, a std::string built from a literal on every frame may allocate
 template <typename T1, typename T2>
-void plot_bar_stack(std::string label_id, const T1* bar_length, std::vector<T2> bar_value, int item_count, double group_size, double shift, ImPlotBarGroupsFlags flags);
\ No newline at end of file
+void plot_bar_stack(const std::string& label_id, const T1* bar_length, const std::vector<T2>& bar_value, int item_count, double group_size, double shift, ImPlotBarGroupsFlags flags) {
+    plot_bar_stack(label_id.c_str(), bar_length, bar_value, item_count, group_size, shift, flags);
+}
+
+// Same as above, but reuses a persistent index instead of accumulating bar_length on every call.
+// The output of the last frame is reused while index.version is unchanged, increment it after changing bar_value in place.
+// BarStackFlags_Follow treats that as an edit too, only append() keeps its bars.
+// Enum states do not match it, keep them as BarStackEnumState<E> and pass BarStackFlags_Categorical.
+template <typename T, typename std::enable_if<!std::is_enum<T>::value, int>::type = 0>
+void plot_bar_stack(const char* label_id, const BarStackIndex& index, const std::vector<T>& bar_value, double group_size, double shift, ImPlotBarGroupsFlags flags);
+
+// Same as above, but plots a timeline in place
+template <typename T>
+void plot_bar_stack(const char* label_id, const BarStackTimeline<T>& timeline, double group_size, double shift, ImPlotBarGroupsFlags flags);
+
+// Same as above, but plots columns owned elsewhere in place
+template <typename T>
+void plot_bar_stack(const char* label_id, const BarStackTimelineView<T>& view, double group_size, double shift, ImPlotBarGroupsFlags flags);
+
+// Same as above, but decodes the visible blocks of a compressed timeline. They are kept per item until the view or the data changes.
+// BarStackFlags_Follow is ignored, the decoded segments change as the view scrolls.
+template <typename T>
+void plot_bar_stack(const char* label_id, const BarStackCompressedTimeline<T>& timeline, double group_size, double shift, ImPlotBarGroupsFlags flags);
+
+// Plots transitions given as absolute timestamps, without converting them into durations: segment i spans
+// [timestamps[i], timestamps[i + 1]) in state states[i], so count timestamps make count - 1 segments. Timestamps must be non-decreasing.
+// They are rebased on the time origin of the plot in integer arithmetic before any conversion to double, so nanosecond
+// epoch timestamps keep sub-microsecond edges. The X axis shows time since that origin.
+// With BarStackFlags_Follow the timestamps are taken as append only, like raw lengths: a grown count appends, the same count is
+// taken as unchanged, a smaller count or another array starts over.
+template <typename T, typename std::enable_if<!std::is_enum<T>::value, int>::type = 0>
+void plot_bar_stack_timestamps(const char* label_id, const uint64_t* timestamps, const T* states, int count, double group_size, double shift, ImPlotBarGroupsFlags flags);
+
+// Enum states are plotted as BarStackEnumState<E> with BarStackFlags_Categorical
+template <typename E, typename std::enable_if<std::is_enum<E>::value, int>::type = 0>
+void plot_bar_stack_timestamps(const char* label_id, const uint64_t* timestamps, const E* states, int count, double group_size, double shift, ImPlotBarGroupsFlags flags) {
+    plot_bar_stack_timestamps(label_id, timestamps, (const BarStackEnumState<E>*)states, count, group_size, shift, flags | BarStackFlags_Categorical);
+}
+
+// Time origin of the current plot, X = 0 for plot_bar_stack_timestamps. Until it is set, the first timestamp plotted in the plot becomes the origin,
+// and is taken again from the first timestamp once that moves more than 2^53 time units away, past the exact range of a double.
+// Like the other state kept per plot it is freed once the plot is not drawn for a while, call it every frame like the Setup functions.
+void set_bar_stack_time_origin(uint64_t origin);
+uint64_t get_bar_stack_time_origin();
+
+// Plots many timelines as one item, lane i is centered at shift + i * lane_spacing on the Y axis.
+// Lanes outside the visible Y range are skipped without reading their data.
+template <typename T>
+void plot_bar_stack_lanes(const char* label_id, const BarStackTimeline<T>* const* lanes, int lane_count, double group_size, double lane_spacing, double shift, ImPlotBarGroupsFlags flags);
+
+// Draws state_labels[state] centered on the visible part of the segments of a timeline plotted at shift, on segments wide enough
+// to hold the text plus min_spacing pixels. States outside [0, state_count) and null labels are not drawn.
+// label_id is the one the timeline was plotted with, nothing is drawn while that item is hidden from the legend.
+// The layout cost is bounded by the plot width, not by the number of transitions, and all glyphs are rendered in one pass.
+template <typename T>
+void plot_bar_stack_labels(const char* label_id, const BarStackTimeline<T>& timeline, const char* const* state_labels, int state_count, double shift, float min_spacing = 4.0f);
+
+// Same as above for the lanes of plot_bar_stack_lanes, lanes outside the visible Y range are skipped
+template <typename T>
+void plot_bar_stack_lanes_labels(const char* label_id, const BarStackTimeline<T>* const* lanes, int lane_count, double lane_spacing, double shift, const char* const* state_labels, int state_count, float min_spacing = 4.0f);
+
+// Segment of a stack under the mouse
+template <typename T>
+struct BarStackHover {
+    int      lane;     // lane of plot_bar_stack_lanes, 0 for a single stack
+    int      segment;  // index of the segment in its stack
+    bool     timed;    // start and duration are set, the segment is from a timeline
+    uint64_t start;
+    uint64_t duration;
+    T        value;
+    double   x_min;    // horizontal extents of the segment in plot units
+    double   x_max;
+    double   y_min;    // vertical extents of the lane in plot units
+    double   y_max;
+};
+
+// Finds the segment of a timeline plotted by plot_bar_stack under the mouse in O(log n), returns false when the plot is not
+// hovered, the item is hidden from the legend or no segment is under the mouse. Call it between BeginPlot and EndPlot with the
+// arguments the stack was plotted with.
+template <typename T>
+bool hover_bar_stack(const char* label_id, const BarStackTimeline<T>& timeline, double group_size, double shift, BarStackHover<T>* hover);
+
+// Same as above for a stack plotted from a BarStackIndex, start and duration are left unset
+template <typename T>
+bool hover_bar_stack(const char* label_id, const BarStackIndex& index, const std::vector<T>& bar_value, double group_size, double shift, BarStackHover<T>* hover);
+
+// Same as above for plot_bar_stack_lanes, the lane is picked from the mouse Y without visiting the other lanes
+template <typename T>
+bool hover_bar_stack_lanes(const char* label_id, const BarStackTimeline<T>* const* lanes, int lane_count, double group_size, double lane_spacing, double shift, BarStackHover<T>* hover);
+
+// Outlines the hovered segment and shows its extents and value in a tooltip, the value is shown with state_labels when given
+template <typename T>
+void show_bar_stack_hover(const BarStackHover<T>& hover, const char* const* state_labels = nullptr, int state_count = 0);